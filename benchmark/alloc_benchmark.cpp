@@ -0,0 +1,155 @@
+#include "benchmark.h"
+#include "../src/kruskal_associater.h"
+#include "../src/skel_updater.h"
+#include "../src/detection_stream.h"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <cerrno>
+#if defined(_MSC_VER) && defined(_DEBUG)
+#include <crtdbg.h>
+#endif
+
+
+// heap allocation counter, at the level of malloc so Eigen's temporaries are seen next to the std containers: the
+// debug crt hook on msvc, glibc's malloc interposed elsewhere. both only count while the benchmark measures and
+// allocate as before, other builds have no hook and report nothing counted. builds defining EIGEN_RUNTIME_NO_MALLOC
+// also forbid Eigen to allocate in the measured frames, so an assert points at the first allocation
+namespace
+{
+	std::atomic<bool> counting{ false };
+	std::atomic<long long> allocCnt{ 0 };
+
+	// frames tracked to reach the high-water marks, then the following frames are measured
+	const int WARMUP_FRAME_SIZE = 150;
+	const int MEASURE_FRAME_SIZE = 150;
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+	const char* COUNTED = "all crt allocations";
+	int AllocHook(int allocType, void*, size_t, int, long, const unsigned char*, int)
+	{
+		if (counting && (allocType == _HOOK_ALLOC || allocType == _HOOK_REALLOC))
+			allocCnt++;
+		return TRUE;
+	}
+#elif defined(__GLIBC__)
+	const char* COUNTED = "all malloc calls";
+#else
+	const char* COUNTED = nullptr;
+#endif
+}
+
+
+#if !(defined(_MSC_VER) && defined(_DEBUG)) && defined(__GLIBC__)
+extern "C"
+{
+	void* __libc_malloc(size_t size);
+	void* __libc_calloc(size_t cnt, size_t size);
+	void* __libc_realloc(void* ptr, size_t size);
+	void* __libc_memalign(size_t alignment, size_t size);
+
+	void* malloc(size_t size)
+	{
+		if (counting.load(std::memory_order_relaxed))
+			allocCnt++;
+		return __libc_malloc(size);
+	}
+
+	void* calloc(size_t cnt, size_t size)
+	{
+		if (counting.load(std::memory_order_relaxed))
+			allocCnt++;
+		return __libc_calloc(cnt, size);
+	}
+
+	void* realloc(void* ptr, size_t size)
+	{
+		if (counting.load(std::memory_order_relaxed))
+			allocCnt++;
+		return __libc_realloc(ptr, size);
+	}
+
+	void* aligned_alloc(size_t alignment, size_t size)
+	{
+		if (counting.load(std::memory_order_relaxed))
+			allocCnt++;
+		return __libc_memalign(alignment, size);
+	}
+
+	int posix_memalign(void** ptr, size_t alignment, size_t size)
+	{
+		if (counting.load(std::memory_order_relaxed))
+			allocCnt++;
+		*ptr = __libc_memalign(alignment, size);
+		return *ptr != nullptr || size == 0 ? 0 : ENOMEM;
+	}
+}
+#endif
+
+
+void BenchmarkAlloc()
+{
+#if defined(_MSC_VER) && defined(_DEBUG)
+	_CrtSetAllocHook(AllocHook);
+#endif
+	const ShelfData shelf = LoadShelf();
+
+	KruskalAssociater associater(SKEL19, shelf.cams);
+	SetShelfParams(associater);
+	SkelTriangulateUpdater skelUpdater(SKEL19);
+	skelUpdater.SetTriangulateThresh(0.05f);
+	skelUpdater.SetMinTrackCnt(5);
+
+	// the warm-up tracks the first frames and reaches the high-water marks, the measured frames follow on unseen
+	// inputs, so buffers a new crowd outgrows show up. the frames are read up front, so the reader thread allocates
+	// nothing while counting
+	std::vector<std::vector<OpenposeDetection>> frames;
+	{
+		DetectionStream detectionStream(shelf.filenames, shelf.preprocess);
+		std::vector<OpenposeDetection> detections;
+		while (frames.size() < WARMUP_FRAME_SIZE + MEASURE_FRAME_SIZE && detectionStream.Read(detections))
+			frames.emplace_back(std::move(detections));
+	}
+	const int warmupSize = std::min(WARMUP_FRAME_SIZE, int(frames.size()) / 2);
+	const int measureSize = int(frames.size()) - warmupSize;
+
+	long long warmupCnt = 0, measureCnt = 0;
+	int allocFrameCnt = 0;
+	Timer timer;
+	double time = 0.;
+	for (int frameIdx = 0; frameIdx < frames.size(); frameIdx++) {
+		const bool measured = frameIdx >= warmupSize;
+		associater.SetDetections(frames[frameIdx]);
+		associater.SetSkels3dPrev(skelUpdater.GetSkel3d());
+		const long long cnt = allocCnt;
+		timer.Reset();
+		counting = true;
+#ifdef EIGEN_RUNTIME_NO_MALLOC
+		Eigen::internal::set_is_malloc_allowed(!measured);
+#endif
+		associater.Associate();
+#ifdef EIGEN_RUNTIME_NO_MALLOC
+		Eigen::internal::set_is_malloc_allowed(true);
+#endif
+		counting = false;
+		if (measured) {
+			time += timer.Elapsed();
+			measureCnt += allocCnt - cnt;
+			allocFrameCnt += allocCnt > cnt ? 1 : 0;
+		}
+		else
+			warmupCnt += allocCnt - cnt;
+		skelUpdater.Update(associater.GetSkels2d(), shelf.projs);
+	}
+
+	std::cout << warmupSize << " warm-up frames, then " << measureSize << " measured frames, "
+		<< 1e3 * time / std::max(measureSize, 1) << "ms per measured frame" << std::endl;
+	if (COUNTED != nullptr)
+		std::cout << "counting " << COUNTED << ": warm-up " << warmupCnt << " allocations (" << double(warmupCnt) / std::max(warmupSize, 1)
+			<< " per frame), measured " << measureCnt << " allocations in " << allocFrameCnt << " frames" << std::endl;
+	else
+		std::cout << "allocations not counted, only msvc debug and glibc builds hook the allocator" << std::endl;
+#if defined(_MSC_VER) && defined(_DEBUG)
+	_CrtSetAllocHook(nullptr);
+#endif
+}
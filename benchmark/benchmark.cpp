@@ -0,0 +1,40 @@
+#include "benchmark.h"
+#include "../src/kruskal_associater.h"
+
+
+ShelfData LoadShelf()
+{
+	ShelfData shelf;
+	shelf.cams = ParseCameras("../data/shelf/calibration.json");
+	shelf.projs.resize(3, shelf.cams.size() * 4);
+	shelf.preprocess.type = SKEL19;
+	shelf.preprocess.normalizePaf = true;
+	for (auto camIter = shelf.cams.begin(); camIter != shelf.cams.end(); camIter++) {
+		shelf.projs.middleCols(4 * shelf.filenames.size(), 4) = camIter->second.eiProj;
+		shelf.filenames.emplace_back("../data/shelf/detection/" + camIter->first + ".txt");
+		shelf.preprocess.imgSizes.emplace_back(camIter->second.imgSize);
+	}
+	return shelf;
+}
+
+
+void SetShelfParams(KruskalAssociater& associater)
+{
+	SetSyntheticParams(associater);
+	associater.SetMaxTempDist(0.2f);
+	associater.SetTempWeight(2.f);
+}
+
+
+void SetSyntheticParams(KruskalAssociater& associater)
+{
+	associater.SetMaxEpiDist(0.15f);
+	associater.SetEpiWeight(2.f);
+	associater.SetViewWeight(2.f);
+	associater.SetPafWeight(1.f);
+	associater.SetHierWeight(.5f);
+	associater.SetViewCntWelsh(1.5f);
+	associater.SetMinCheckCnt(1);
+	associater.SetNodeMultiplex(true);
+	associater.SetNormalizeEdge(true);
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <map>
+#include <vector>
+#include <Eigen/Core>
+#include "../src/camera.h"
+#include "../src/openpose.h"
+
+
+class KruskalAssociater;
+
+
+// benchmarks run from the benchmark/ directory, data paths are relative to it like the other executables
+void BenchmarkParse();
+void BenchmarkSnapshot();
+void BenchmarkEpi();
+void BenchmarkAlloc();
+void BenchmarkClique();
+void BenchmarkView();
+void BenchmarkHierarchical();
+void BenchmarkTemporal();
+void BenchmarkMotion();
+
+
+// the shelf sequence: its cameras in calibration order, their stacked projections and the detection files
+struct ShelfData
+{
+	std::map<std::string, Camera> cams;
+	Eigen::Matrix3Xf projs;
+	std::vector<std::string> filenames;
+	DetectionPreprocess preprocess;
+};
+
+ShelfData LoadShelf();
+
+// same settings as evaluate_shelf
+void SetShelfParams(KruskalAssociater& associater);
+
+// the shelf settings without the temporal gate and weight
+void SetSyntheticParams(KruskalAssociater& associater);
+
+
+struct Timer
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	void Reset() { start = std::chrono::steady_clock::now(); }
+	double Elapsed() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); }
+};
+
+
+template<typename Derived>
+inline bool BitEqual(const Eigen::DenseBase<Derived>& a, const Eigen::DenseBase<Derived>& b)
+{
+	if (a.rows() != b.rows() || a.cols() != b.cols())
+		return false;
+	for (int j = 0; j < a.cols(); j++)
+		for (int i = 0; i < a.rows(); i++)
+			if (std::memcmp(&a(i, j), &b(i, j), sizeof(a(i, j))) != 0)
+				return false;
+	return true;
+}
@@ -0,0 +1,104 @@
+#include "benchmark.h"
+#include "../src/kruskal_associater.h"
+#include "../src/skel_updater.h"
+#include "../src/detection_stream.h"
+#include <iostream>
+#include <iomanip>
+#include <climits>
+#include <algorithm>
+
+
+namespace
+{
+	bool Equal(const std::map<int, Eigen::Matrix3Xf>& a, const std::map<int, Eigen::Matrix3Xf>& b)
+	{
+		if (a.size() != b.size())
+			return false;
+		for (auto iterA = a.begin(), iterB = b.begin(); iterA != a.end(); iterA++, iterB++)
+			if (iterA->first != iterB->first || !BitEqual(iterA->second, iterB->second))
+				return false;
+		return true;
+	}
+}
+
+
+void BenchmarkClique()
+{
+	const ShelfData shelf = LoadShelf();
+
+	// exhaustive enumeration tracks the sequence, every budget then replays the same inputs
+	KruskalAssociater associater(SKEL19, shelf.cams);
+	SetShelfParams(associater);
+	SkelTriangulateUpdater skelUpdater(SKEL19);
+	skelUpdater.SetTriangulateThresh(0.05f);
+	skelUpdater.SetMinTrackCnt(5);
+
+	DetectionStream detectionStream(shelf.filenames, shelf.preprocess);
+	std::vector<std::vector<OpenposeDetection>> frames;
+	std::vector<std::map<int, Eigen::Matrix4Xf>> skels3dPrev;
+	std::vector<std::map<int, Eigen::Matrix3Xf>> skels2d;
+	std::vector<OpenposeDetection> detections;
+	long long cliqueCnt = 0, popCnt = 0;
+	Timer timer;
+	double time = 0., popTime = 0.;
+	while (detectionStream.Read(detections)) {
+		frames.emplace_back(detections);
+		skels3dPrev.emplace_back(skelUpdater.GetSkel3d());
+		associater.SetDetections(std::move(detections));
+		associater.SetSkels3dPrev(skels3dPrev.back());
+		timer.Reset();
+		associater.Associate();
+		time += timer.Elapsed();
+		cliqueCnt += associater.GetCliqueCnt();
+		popCnt += associater.GetPopCnt();
+		popTime += associater.GetPopTime();
+		skels2d.emplace_back(associater.GetSkels2d());
+		skelUpdater.Update(associater.GetSkels2d(), shelf.projs);
+	}
+	std::cout << frames.size() << " frames, exhaustive: " << double(cliqueCnt) / frames.size() << " cliques, "
+		<< 1e3 * time / frames.size() << "ms per frame" << std::endl;
+	std::cout << "assign: " << double(popCnt) / frames.size() << " pops per frame, " << 1e3 * popTime / frames.size()
+		<< "ms per frame, " << 1e-6 * popCnt / popTime << "M pops/s" << std::endl;
+	auto HitRate = [](const long long& hitCnt, const long long& missCnt) { return 100. * hitCnt / std::max(hitCnt + missCnt, 1LL); };
+	std::cout << "compatibility cache: joint " << HitRate(associater.GetJointCacheHitCnt(), associater.GetJointCacheMissCnt())
+		<< "% hits of " << double(associater.GetJointCacheHitCnt() + associater.GetJointCacheMissCnt()) / frames.size()
+		<< " per frame, person " << HitRate(associater.GetPersonCacheHitCnt(), associater.GetPersonCacheMissCnt())
+		<< "% hits of " << double(associater.GetPersonCacheHitCnt() + associater.GetPersonCacheMissCnt()) / frames.size()
+		<< " per frame" << std::endl;
+
+	auto Replay = [&](const std::string& name, const int& cliqueBudget, const float& timeBudget, const bool& split) {
+		KruskalAssociater budgeted(SKEL19, shelf.cams);
+		SetShelfParams(budgeted);
+		budgeted.SetCliqueBudget(cliqueBudget);
+		budgeted.SetCliqueTimeBudget(timeBudget);
+		budgeted.SetSplitComponents(split);
+		long long cliqueCnt = 0, componentCnt = 0, nodeCnt = 0;
+		int equalCnt = 0;
+		double time = 0.;
+		for (int frameIdx = 0; frameIdx < frames.size(); frameIdx++) {
+			budgeted.SetDetections(frames[frameIdx]);
+			budgeted.SetSkels3dPrev(skels3dPrev[frameIdx]);
+			timer.Reset();
+			budgeted.Associate();
+			time += timer.Elapsed();
+			cliqueCnt += budgeted.GetCliqueCnt();
+			nodeCnt += budgeted.GetNodeCnt();
+			componentCnt += budgeted.GetComponentCnt();
+			equalCnt += Equal(budgeted.GetSkels2d(), skels2d[frameIdx]) ? 1 : 0;
+		}
+		std::cout << std::setw(16) << name << ": " << double(cliqueCnt) / frames.size() << " cliques, "
+			<< 1e3 * time / frames.size() << "ms per frame, ";
+		if (split)
+			std::cout << double(componentCnt) / frames.size() << " components per frame, ";
+		else
+			std::cout << double(nodeCnt) / frames.size() << " nodes expanded, budget hit in " << budgeted.GetBudgetHitCnt() << " frames, ";
+		std::cout << equalCnt << " frames equal to exhaustive" << std::endl;
+	};
+
+	Replay("split components", 0, 0.f, true);
+	Replay("unlimited", INT_MAX, 0.f, false);
+	for (const int cliqueBudget : { 5000, 2000, 1000, 500, 100 })
+		Replay(std::to_string(cliqueBudget) + " cliques", cliqueBudget, 0.f, false);
+	for (const float timeBudget : { 4e-3f, 2e-3f, 1e-3f })
+		Replay(std::to_string(int(timeBudget * 1e3f)) + "ms", 0, timeBudget, false);
+}
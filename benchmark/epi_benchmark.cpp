@@ -0,0 +1,207 @@
+#include "benchmark.h"
+#include "../src/camera.h"
+#include "../src/detection_stream.h"
+#include "../src/epi_kernel.h"
+#include <iostream>
+#include <Eigen/Eigen>
+
+
+// the per pair Line2LineDist loop with separate normalization that Associater::CalcEpiEdges used before the kernel
+namespace {
+	void CalcEpiEdgeReference(const Eigen::Vector3f& posA, const Eigen::Ref<const Eigen::Matrix3Xf>& raysA, const Eigen::Vector3f& posB,
+		const Eigen::Ref<const Eigen::Matrix3Xf>& raysB, const float& maxDist, const bool& normalize, Eigen::MatrixXf& epi)
+	{
+		auto Line2LineDist = [](const Eigen::Vector3f& pA, const Eigen::Vector3f& rayA, const Eigen::Vector3f& pB, const Eigen::Vector3f& rayB) {
+			if (std::abs(rayA.dot(rayB)) < 1e-5f)
+				return ((pA - pB).cross(rayA)).norm();
+			else
+				return std::abs((pA - pB).dot((rayA.cross(rayB)).normalized()));
+		};
+
+		epi.setConstant(raysA.cols(), raysB.cols(), -1.f);
+		for (int a = 0; a < epi.rows(); a++) {
+			for (int b = 0; b < epi.cols(); b++) {
+				const float dist = Line2LineDist(posA, raysA.col(a), posB, raysB.col(b));
+				if (dist < maxDist)
+					epi(a, b) = 1.f - dist / maxDist;
+			}
+		}
+
+		if (normalize) {
+			Eigen::VectorXf rowFactor = epi.rowwise().sum().transpose().cwiseMax(1.f);
+			Eigen::VectorXf colFactor = epi.colwise().sum().cwiseMax(1.f);
+			for (int i = 0; i < rowFactor.size(); i++)
+				epi.row(i) /= rowFactor[i];
+			for (int i = 0; i < colFactor.size(); i++)
+				epi.col(i) /= colFactor[i];
+		}
+	}
+
+
+	// dense matrix with -1 for the missing edges, which the normalized reference leaves at -1 / rowSum / colSum
+	void ToDense(const Eigen::MatrixXf& epi, Eigen::MatrixXf& dense)
+	{
+		dense = (epi.array() < 0.f).select(-1.f, epi);
+	}
+
+
+	void ToDense(const EdgeGraph& epi, Eigen::MatrixXf& dense)
+	{
+		const EdgeGraph::View rows = epi.Rows();
+		dense.setConstant(epi.GetRows(), epi.GetCols(), -1.f);
+		for (int row = 0; row < epi.GetRows(); row++)
+			for (int i = rows.GetBegin(row); i < rows.GetEnd(row); i++)
+				dense(row, rows.GetNeighbor(i)) = rows.GetWeight(i);
+	}
+
+
+	// runs func over every joint and camera pair of every frame, returns seconds and the largest deviation from the reference
+	template<typename Epi>
+	double Run(void(*func)(const Eigen::Vector3f&, const Eigen::Ref<const Eigen::Matrix3Xf>&, const Eigen::Vector3f&,
+		const Eigen::Ref<const Eigen::Matrix3Xf>&, const float&, const bool&, Epi&),
+		const std::vector<Eigen::Vector3f>& pos, const std::vector<std::vector<std::vector<Eigen::Matrix3Xf>>>& rays,
+		const float& maxDist, const int& repeat, float& maxDiff, int& diffCnt)
+	{
+		Timer timer;
+		Epi epi;
+		Eigen::MatrixXf ref, dense, denseRef;
+		maxDiff = 0.f;
+		diffCnt = 0;
+		double time = 0.;
+		for (const auto& frameRays : rays) {
+			for (int jIdx = 0; jIdx < frameRays.begin()->size(); jIdx++) {
+				for (int viewA = 0; viewA < pos.size(); viewA++) {
+					for (int viewB = viewA + 1; viewB < pos.size(); viewB++) {
+						const Eigen::Matrix3Xf& raysA = frameRays[viewA][jIdx];
+						const Eigen::Matrix3Xf& raysB = frameRays[viewB][jIdx];
+						if (raysA.cols() == 0 || raysB.cols() == 0)
+							continue;
+						timer.Reset();
+						for (int i = 0; i < repeat; i++)
+							func(pos[viewA], raysA, pos[viewB], raysB, maxDist, true, epi);
+						time += timer.Elapsed();
+
+						CalcEpiEdgeReference(pos[viewA], raysA, pos[viewB], raysB, maxDist, true, ref);
+						ToDense(epi, dense);
+						ToDense(ref, denseRef);
+						maxDiff = std::max(maxDiff, (dense - denseRef).cwiseAbs().maxCoeff());
+						diffCnt += int(((dense - denseRef).cwiseAbs().array() > 1e-4f).count());
+					}
+				}
+			}
+		}
+		return time;
+	}
+
+
+	void Report(const std::string& name, const std::vector<Eigen::Vector3f>& pos,
+		const std::vector<std::vector<std::vector<Eigen::Matrix3Xf>>>& rays, const float& maxDist, const int& repeat)
+	{
+		float maxDiff;
+		int diffCnt;
+		const double refTime = Run(CalcEpiEdgeReference, pos, rays, maxDist, repeat, maxDiff, diffCnt);
+		const double scalarTime = Run(EpiKernel::CalcEpiEdgeScalar, pos, rays, maxDist, repeat, maxDiff, diffCnt);
+		std::cout << name << ": reference " << refTime << "s, scalar " << scalarTime << "s (" << refTime / scalarTime
+			<< "x, max diff " << maxDiff << ", " << diffCnt << " > 1e-4)";
+		const double simdTime = Run(EpiKernel::CalcEpiEdge, pos, rays, maxDist, repeat, maxDiff, diffCnt);
+		std::cout << ", simd " << simdTime << "s (" << refTime / simdTime << "x, max diff " << maxDiff << ", " << diffCnt << " > 1e-4)" << std::endl;
+	}
+}
+
+
+void BenchmarkEpi()
+{
+#ifdef __AVX2__
+	std::cout << "simd: avx2" << std::endl;
+#else
+	std::cout << "simd: none, kernel runs the scalar path" << std::endl;
+#endif
+	const float maxDist = 0.15f;
+
+	// shelf detections
+	const std::map<std::string, Camera> cams = ParseCameras("../data/shelf/calibration.json");
+	std::vector<std::string> filenames;
+	std::vector<Eigen::Vector3f> pos;
+	DetectionPreprocess preprocess;
+	preprocess.type = SKEL19;
+	for (const auto& cam : cams) {
+		filenames.emplace_back("../data/shelf/detection/" + cam.first + ".txt");
+		pos.emplace_back(cam.second.eiPos);
+		preprocess.imgSizes.emplace_back(cam.second.imgSize);
+	}
+	DetectionStream detectionStream(filenames, preprocess);
+	std::vector<OpenposeDetection> detections;
+	std::vector<std::vector<std::vector<Eigen::Matrix3Xf>>> rays;
+	while (detectionStream.Read(detections)) {
+		rays.emplace_back(cams.size());
+		auto camIter = cams.begin();
+		for (int view = 0; view < cams.size(); view++, camIter++) {
+			for (const auto& joints : detections[view].joints) {
+				Eigen::Matrix3Xf jointRays(3, joints.cols());
+				for (int i = 0; i < joints.cols(); i++)
+					jointRays.col(i) = camIter->second.CalcRay(joints.block<2, 1>(0, i));
+				rays.back()[view].emplace_back(jointRays);
+			}
+		}
+	}
+	Report("shelf", pos, rays, maxDist, 10);
+
+	// crowded synthetic views: every candidate ray of view B passes through a point hit by some ray of view A
+	for (const int personSize : { 10, 30, 50 }) {
+		std::srand(0);
+		std::vector<std::vector<std::vector<Eigen::Matrix3Xf>>> crowdRays(10, std::vector<std::vector<Eigen::Matrix3Xf>>(pos.size()));
+		for (auto&& frameRays : crowdRays) {
+			const Eigen::Matrix3Xf points = Eigen::Matrix3Xf::Random(3, personSize) * 2.f;
+			for (int view = 0; view < pos.size(); view++) {
+				Eigen::Matrix3Xf viewRays = (points + 0.02f * Eigen::Matrix3Xf::Random(3, personSize)).colwise() - pos[view];
+				viewRays.colwise().normalize();
+				frameRays[view].emplace_back(viewRays);
+			}
+		}
+		Report("crowd " + std::to_string(personSize), pos, crowdRays, maxDist, 10);
+	}
+
+	// epipolar band index against the dense kernel, joints spread over the shelf floor up to head height
+	for (const int personSize : { 5, 10, 20, 30, 50, 100 }) {
+		std::srand(0);
+		std::vector<std::vector<EpiBandIndex>> indices(pos.size(), std::vector<EpiBandIndex>(pos.size()));
+		for (int viewA = 0; viewA < pos.size(); viewA++)
+			for (int viewB = viewA + 1; viewB < pos.size(); viewB++)
+				indices[viewA][viewB] = EpiBandIndex(pos[viewA], pos[viewB]);
+
+		double denseTime = 0., bandTime = 0.;
+		float maxDiff = 0.f;
+		EdgeGraph dense, band;
+		Eigen::MatrixXf denseMat, bandMat;
+		Timer timer;
+		for (int frameIdx = 0; frameIdx < 10; frameIdx++) {
+			Eigen::Matrix3Xf points = Eigen::Matrix3Xf::Random(3, personSize);
+			points.topRows(2) *= 2.f;
+			points.row(2) = (points.row(2).array() + 1.f) * 0.9f;
+			std::vector<Eigen::Matrix3Xf> rays(pos.size());
+			for (int view = 0; view < pos.size(); view++) {
+				rays[view] = (points + 0.02f * Eigen::Matrix3Xf::Random(3, personSize)).colwise() - pos[view];
+				rays[view].colwise().normalize();
+			}
+
+			for (int viewA = 0; viewA < pos.size(); viewA++) {
+				for (int viewB = viewA + 1; viewB < pos.size(); viewB++) {
+					timer.Reset();
+					for (int i = 0; i < 100; i++)
+						EpiKernel::CalcEpiEdge(pos[viewA], rays[viewA], pos[viewB], rays[viewB], maxDist, true, dense);
+					denseTime += timer.Elapsed();
+
+					timer.Reset();
+					for (int i = 0; i < 100; i++)
+						indices[viewA][viewB].CalcEpiEdge(rays[viewA], rays[viewB], maxDist, true, band);
+					bandTime += timer.Elapsed();
+					ToDense(dense, denseMat);
+					ToDense(band, bandMat);
+					maxDiff = std::max(maxDiff, (denseMat - bandMat).cwiseAbs().maxCoeff());
+				}
+			}
+		}
+		std::cout << "band " << personSize << " people: dense " << denseTime << "s, band " << bandTime << "s ("
+			<< denseTime / bandTime << "x, max diff " << maxDiff << ")" << std::endl;
+	}
+}
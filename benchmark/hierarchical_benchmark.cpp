@@ -0,0 +1,65 @@
+#include "benchmark.h"
+#include "synthetic_scene.h"
+#include "../src/hierarchical_associater.h"
+#include <iostream>
+#include <iomanip>
+#include <functional>
+
+
+void BenchmarkHierarchical()
+{
+	const int camSize = 40;
+	const int frameSize = 10;
+	const SyntheticRig rig = MakeRig(camSize);
+	std::mt19937 rng(camSize);
+	std::vector<SyntheticScene> scenes;
+	for (int frameIdx = 0; frameIdx < frameSize; frameIdx++)
+		scenes.emplace_back(MakeScene(rig, camSize, rng));
+
+	auto Run = [&](const std::string& name, Associater& associater, const std::function<void()>& report) {
+		Timer timer;
+		double time = 0.;
+		float puritySum = 0.f, completenessSum = 0.f;
+		int personCnt = 0;
+		for (const SyntheticScene& scene : scenes) {
+			associater.SetDetections(scene.detections);
+			associater.SetSkels3dPrev(std::map<int, Eigen::Matrix4Xf>());
+			timer.Reset();
+			associater.Associate();
+			time += timer.Elapsed();
+			float purity, completeness;
+			scene.Evaluate(associater.GetSkels2d(), purity, completeness);
+			puritySum += purity;
+			completenessSum += completeness;
+			personCnt += int(associater.GetSkels2d().size());
+		}
+		std::cout << std::setw(24) << name << ": " << 1e3 * time / frameSize << "ms per frame, " << double(personCnt) / frameSize
+			<< " persons of " << camSize << ", purity " << puritySum / frameSize << ", completeness " << completenessSum / frameSize;
+		report();
+		std::cout << std::endl;
+	};
+
+	for (const float minViewOverlap : { 0.f, 0.1f }) {
+		KruskalAssociater associater(SKEL19, rig.cams);
+		SetSyntheticParams(associater);
+		associater.SetWorkingVolume(rig.volumeMin, rig.volumeMax);
+		associater.SetMinViewOverlap(minViewOverlap);
+		Run("flat, min overlap " + std::to_string(minViewOverlap).substr(0, 3), associater,
+			[&]() { std::cout << ", " << associater.GetViewPairCnt() << " view pairs"; });
+	}
+
+	// clusters of the rig's sites, then clustered by what the cameras see
+	std::vector<std::pair<std::string, std::vector<int>>> clusterings = { { "sites", rig.sites } };
+	for (const int clusterSize : { 8, 4 })
+		clusterings.emplace_back(std::to_string(clusterSize) + " clusters", ClusterCameras(rig.cams, rig.volumeMin, rig.volumeMax, clusterSize));
+	for (const auto& clustering : clusterings) {
+		HierarchicalAssociater associater(SKEL19, rig.cams, clustering.second);
+		associater.SetMaxEpiDist(0.15f);
+		for (int cluster = 0; cluster < associater.GetClusterSize(); cluster++)
+			SetSyntheticParams(associater.GetCluster(cluster));
+		Run("hierarchical, " + clustering.first, associater, [&]() {
+			std::cout << ", " << associater.GetMergeCnt() << " merges and " << associater.GetDropCnt() << " drops in the last, "
+				<< 1e3 * associater.GetClusterTime() << "ms clusters and " << 1e3 * associater.GetMergeTime() << "ms merge";
+		});
+	}
+}
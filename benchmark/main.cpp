@@ -0,0 +1,38 @@
+#include "benchmark.h"
+#include <map>
+#include <iostream>
+#include <functional>
+
+
+int main(int argc, char** argv)
+{
+	const std::map<std::string, std::function<void()>> benchmarks = {
+		{ "parse", BenchmarkParse },
+		{ "snapshot", BenchmarkSnapshot },
+		{ "epi", BenchmarkEpi },
+		{ "alloc", BenchmarkAlloc },
+		{ "clique", BenchmarkClique },
+		{ "view", BenchmarkView },
+		{ "hier", BenchmarkHierarchical },
+		{ "temporal", BenchmarkTemporal },
+		{ "motion", BenchmarkMotion },
+	};
+
+	std::vector<std::string> names;
+	for (int i = 1; i < argc; i++)
+		names.emplace_back(argv[i]);
+	if (names.empty())
+		for (const auto& benchmark : benchmarks)
+			names.emplace_back(benchmark.first);
+
+	for (const std::string& name : names) {
+		auto iter = benchmarks.find(name);
+		if (iter == benchmarks.end()) {
+			std::cerr << "unknown benchmark: " << name << std::endl;
+			return 1;
+		}
+		std::cout << "[" << name << "]" << std::endl;
+		iter->second();
+	}
+	return 0;
+}
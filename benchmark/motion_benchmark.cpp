@@ -0,0 +1,68 @@
+#include "benchmark.h"
+#include "synthetic_scene.h"
+#include "../src/kruskal_associater.h"
+#include "../src/skel_updater.h"
+#include <iostream>
+#include <iomanip>
+
+
+void BenchmarkMotion()
+{
+	const int frameSize = 200;
+	const float fps = 25.f;
+	const SyntheticRig rig = MakeRig(5);
+	Eigen::Matrix3Xf projs(3, rig.cams.size() * 4);
+	int view = 0;
+	for (auto camIter = rig.cams.begin(); camIter != rig.cams.end(); camIter++, view++)
+		projs.middleCols(4 * view, 4) = camIter->second.eiProj;
+
+	for (const float speed : { 1.f, 3.f, 6.f }) {
+		std::mt19937 rng(static_cast<unsigned>(speed));
+		const std::vector<std::vector<Eigen::Matrix3Xf>> run = MakeRun(rig, std::vector<float>(6, speed), frameSize, fps, rng);
+		std::vector<SyntheticScene> scenes;
+		for (const auto& skels3d : run)
+			scenes.emplace_back(RenderScene(rig, skels3d, rng));
+
+		// the last skeletons gated at a fixed distance, then the predicted ones at their errors
+		for (const float maxTempDist : { 0.2f, 0.5f, 0.f }) {
+			KruskalAssociater associater(SKEL19, rig.cams);
+			SetSyntheticParams(associater);
+			associater.SetTempWeight(2.f);		// the temporal weight of the shelf
+			associater.SetMaxTempDist(maxTempDist > 0.f ? maxTempDist : 0.5f);
+			SkelTriangulateUpdater skelUpdater(SKEL19);
+			skelUpdater.SetMinTrackCnt(5);
+			long long tempEdgeCnt = 0, cliqueCnt = 0;
+			int switchCnt = 0;
+			std::vector<int> identities(run.front().size(), -1);
+			Timer timer;
+			double time = 0.;
+			for (const SyntheticScene& scene : scenes) {
+				associater.SetDetections(scene.detections);
+				if (maxTempDist > 0.f)
+					associater.SetSkels3dPrev(skelUpdater.GetSkel3d());
+				else
+					associater.SetSkels3dPrev(skelUpdater.GetPredictedSkel3d(), skelUpdater.GetPredictionErrors());
+				timer.Reset();
+				associater.Associate();
+				time += timer.Elapsed();
+				tempEdgeCnt += associater.GetTempEdgeCnt();
+				cliqueCnt += associater.GetCliqueCnt();
+				skelUpdater.Update(associater.GetSkels2d(), projs);
+
+				// a person changing from one tracked identity to another
+				const std::vector<int> frameIdentities = scene.Identify(associater.GetSkels2d());
+				for (int pIdx = 0; pIdx < frameIdentities.size(); pIdx++) {
+					if (frameIdentities[pIdx] < 0)
+						continue;
+					if (identities[pIdx] >= 0 && identities[pIdx] != frameIdentities[pIdx])
+						switchCnt++;
+					identities[pIdx] = frameIdentities[pIdx];
+				}
+			}
+			const std::string name = maxTempDist > 0.f ? "last, gate " + std::to_string(maxTempDist).substr(0, 3) : "predicted";
+			std::cout << std::setw(4) << speed << "m/s, " << std::setw(14) << name << ": " << double(tempEdgeCnt) / frameSize
+				<< " temporal edges, " << double(cliqueCnt) / frameSize << " cliques, " << 1e3 * time / frameSize
+				<< "ms per frame, " << switchCnt << " id switches" << std::endl;
+		}
+	}
+}
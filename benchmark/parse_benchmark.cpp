@@ -0,0 +1,164 @@
+#include "benchmark.h"
+#include "../src/openpose.h"
+#include "../src/detection_stream.h"
+#include "../src/skel_driver.h"
+#include "../src/math_util.h"
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <filesystem>
+
+
+// the single threaded ifstream readers, kept as reference for output and throughput
+namespace {
+	std::vector<OpenposeDetection> StreamParseDetections(const std::string& filename)
+	{
+		std::ifstream fs(filename);
+		int skelType, frameSize;
+		fs >> skelType >> frameSize;
+		std::vector<OpenposeDetection> detections(frameSize);
+		for (OpenposeDetection& detection : detections)
+			detection = ParseDetection(fs, SkelType(skelType));
+		return detections;
+	}
+
+	// the frame by frame path of DetectionStream, parsed from the mapping as the prefetch thread reads
+	std::vector<OpenposeDetection> SourceParseDetections(const std::string& filename)
+	{
+		TextDetectionSource source(filename);
+		std::vector<OpenposeDetection> detections(source.GetFrameSize());
+		for (OpenposeDetection& detection : detections)
+			source.Read(detection);
+		return detections;
+	}
+
+	std::vector<std::map<int, Eigen::Matrix4Xf>> StreamParseSkels(const std::string& filename)
+	{
+		std::ifstream fs(filename);
+		int jointSize, frameSize, personSize, identity;
+		fs >> jointSize >> frameSize;
+		std::vector<std::map<int, Eigen::Matrix4Xf>> skels(frameSize);
+		for (int frameIdx = 0; frameIdx < frameSize; frameIdx++) {
+			fs >> personSize;
+			for (int pIdx = 0; pIdx < personSize; pIdx++) {
+				fs >> identity;
+				Eigen::Matrix4Xf skel(4, jointSize);
+				for (int i = 0; i < 4; i++)
+					for (int jIdx = 0; jIdx < jointSize; jIdx++)
+						fs >> skel(i, jIdx);
+				skels[frameIdx].insert(std::make_pair(identity, skel));
+			}
+		}
+		return skels;
+	}
+
+	Eigen::MatrixXf StreamLoadMat(const std::string& filename)
+	{
+		std::ifstream fs(filename);
+		int rows, cols;
+		fs >> rows >> cols;
+		Eigen::MatrixXf mat(rows, cols);
+		for (int i = 0; i < rows; i++)
+			for (int j = 0; j < cols; j++)
+				fs >> mat(i, j);
+		return mat;
+	}
+
+	// the first half of a file, as left by an interrupted writer
+	std::string Truncate(const std::string& filename)
+	{
+		const std::string truncated = (std::filesystem::temp_directory_path() / ("truncated_" + std::filesystem::path(filename).filename().string())).string();
+		std::ifstream ifs(filename, std::ios::binary);
+		std::string data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+		std::ofstream(truncated, std::ios::binary).write(data.data(), data.size() / 2);
+		return truncated;
+	}
+
+	template<typename Result>
+	void Reject(const std::string& name, const std::string& filename, bool(*parser)(const std::string&, Result&))
+	{
+		const std::string truncated = Truncate(filename);
+		Result result;
+		const bool accepted = parser(truncated, result);
+		std::cout << name << ": truncated file " << (accepted ? "ACCEPTED" : "rejected") << std::endl;
+		std::filesystem::remove(truncated);
+	}
+
+	bool Equal(const std::vector<OpenposeDetection>& a, const std::vector<OpenposeDetection>& b)
+	{
+		if (a.size() != b.size())
+			return false;
+		for (int frameIdx = 0; frameIdx < a.size(); frameIdx++) {
+			if (a[frameIdx].type != b[frameIdx].type)
+				return false;
+			for (int jIdx = 0; jIdx < a[frameIdx].joints.size(); jIdx++)
+				if (!BitEqual(a[frameIdx].joints[jIdx], b[frameIdx].joints[jIdx]))
+					return false;
+			for (int pafIdx = 0; pafIdx < a[frameIdx].pafs.size(); pafIdx++)
+				if (!BitEqual(a[frameIdx].pafs[pafIdx], b[frameIdx].pafs[pafIdx]))
+					return false;
+		}
+		return true;
+	}
+
+	bool Equal(const std::vector<std::map<int, Eigen::Matrix4Xf>>& a, const std::vector<std::map<int, Eigen::Matrix4Xf>>& b)
+	{
+		if (a.size() != b.size())
+			return false;
+		for (int frameIdx = 0; frameIdx < a.size(); frameIdx++) {
+			if (a[frameIdx].size() != b[frameIdx].size())
+				return false;
+			for (auto iterA = a[frameIdx].begin(), iterB = b[frameIdx].begin(); iterA != a[frameIdx].end(); iterA++, iterB++)
+				if (iterA->first != iterB->first || !BitEqual(iterA->second, iterB->second))
+					return false;
+		}
+		return true;
+	}
+
+	bool Equal(const Eigen::MatrixXf& a, const Eigen::MatrixXf& b) { return BitEqual(a, b); }
+
+	template<typename Result>
+	void Compare(const std::string& name, const std::vector<std::string>& filenames,
+		Result(*reference)(const std::string&), Result(*parser)(const std::string&), const int& repeat = 5)
+	{
+		double bytes = 0.;
+		for (const std::string& filename : filenames)
+			bytes += double(std::filesystem::file_size(filename));
+
+		bool equal = true;
+		double refTime = 0., parseTime = 0.;
+		for (int i = 0; i < repeat; i++) {
+			for (const std::string& filename : filenames) {
+				Timer timer;
+				const Result ref = reference(filename);
+				refTime += timer.Elapsed();
+				timer.Reset();
+				const Result result = parser(filename);
+				parseTime += timer.Elapsed();
+				equal = equal && Equal(ref, result);
+			}
+		}
+
+		const double mb = bytes * repeat / (1024. * 1024.);
+		std::cout << name << ": " << bytes / (1024. * 1024.) << " MB, ifstream " << mb / refTime << " MB/s, mapped "
+			<< mb / parseTime << " MB/s, speedup " << refTime / parseTime << "x, " << (equal ? "bit-identical" : "MISMATCH") << std::endl;
+	}
+}
+
+
+void BenchmarkParse()
+{
+	std::vector<std::string> detectionFiles;
+	for (int view = 0; view < 5; view++)
+		detectionFiles.emplace_back("../data/shelf/detection/" + std::to_string(view) + ".txt");
+
+	Compare<std::vector<OpenposeDetection>>("detections", detectionFiles, StreamParseDetections, ParseDetections);
+	Compare<std::vector<OpenposeDetection>>("detection source", detectionFiles, StreamParseDetections, SourceParseDetections);
+	Compare<std::vector<std::map<int, Eigen::Matrix4Xf>>>("skels", { "../data/shelf/gt.txt", "../data/shelf/skel.txt" }, StreamParseSkels, ParseSkels);
+	Compare<Eigen::MatrixXf>("mat", { "../data/skel/SKEL19/joints.txt", "../data/skel/SKEL19/jshape_blend.txt" },
+		StreamLoadMat, MathUtil::LoadMat<float>);
+
+	Reject<std::vector<OpenposeDetection>>("detections", detectionFiles.front(), ParseDetections);
+	Reject<std::vector<std::map<int, Eigen::Matrix4Xf>>>("skels", "../data/shelf/gt.txt", ParseSkels);
+	Reject<Eigen::MatrixXf>("mat", "../data/skel/SKEL19/jshape_blend.txt", MathUtil::LoadMat<float>);
+}
@@ -0,0 +1,95 @@
+#include "benchmark.h"
+#include "../src/skel_snapshot.h"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <thread>
+
+
+namespace
+{
+	// publishes fixed skeletons, every identity has a fitted param
+	class StaticUpdater : public SkelUpdater
+	{
+	public:
+		StaticUpdater(const SkelType& type, const int& personSize) : SkelUpdater(type), m_param(type) {
+			m_param.data.setRandom();
+			for (int pIdx = 0; pIdx < personSize; pIdx++)
+				m_skels.insert(std::make_pair(pIdx, Eigen::Matrix4Xf::Random(4, GetSkelDef(type).jointSize)));
+		}
+		virtual void Update(const std::map<int, Eigen::Matrix3Xf>& skels2d, const Eigen::Matrix3Xf& projs) override {}
+		virtual const SkelParam* GetSkelParam(const int& identity) const override { return &m_param; }
+
+	private:
+		SkelParam m_param;
+	};
+
+
+	void RunSnapshot(const int& readerSize, const int& personSize, const int& frameSize, const double& interval)
+	{
+		const std::string name = "4d_association_snapshot_benchmark";
+		const StaticUpdater updater(SKEL19, personSize);
+		SkelSnapshotWriter writer;
+		if (!writer.Create(name, SKEL19)) {
+			std::cerr << "can not create skel snapshot" << std::endl;
+			return;
+		}
+
+		// readers poll their own mapping like separate processes would
+		std::atomic<bool> stop{ false };
+		std::vector<std::vector<double>> latencies(readerSize);
+		std::vector<int> retryCnts(readerSize, 0);
+		std::vector<int> mismatchCnts(readerSize, 0);
+		std::vector<std::thread> readers;
+		for (int rIdx = 0; rIdx < readerSize; rIdx++) {
+			readers.emplace_back([&, rIdx] {
+				SkelSnapshotReader reader;
+				if (!reader.Open(name))
+					return;
+				SkelSnapshot snapshot;
+				while (!stop) {
+					if (!reader.Read(snapshot)) {
+						std::this_thread::yield();
+						continue;
+					}
+					latencies[rIdx].emplace_back(std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count() - snapshot.timestamp);
+					if (snapshot.skels.size() != personSize || snapshot.params.size() != personSize
+						|| !BitEqual(snapshot.skels.begin()->second, updater.GetSkel3d().begin()->second))
+						mismatchCnts[rIdx]++;
+				}
+				retryCnts[rIdx] = reader.GetRetryCnt();
+			});
+		}
+
+		Timer timer;
+		for (int frameIdx = 0; frameIdx < frameSize; frameIdx++) {
+			writer.Publish(updater, frameIdx);
+			while (timer.Elapsed() < (frameIdx + 1) * interval)
+				std::this_thread::yield();
+		}
+		stop = true;
+		for (auto&& reader : readers)
+			reader.join();
+
+		std::vector<double> all;
+		int retryCnt = 0, mismatchCnt = 0;
+		for (int rIdx = 0; rIdx < readerSize; rIdx++) {
+			all.insert(all.end(), latencies[rIdx].begin(), latencies[rIdx].end());
+			retryCnt += retryCnts[rIdx];
+			mismatchCnt += mismatchCnts[rIdx];
+		}
+		std::sort(all.begin(), all.end());
+		auto Percentile = [&](const double& p) { return all.empty() ? 0. : 1e6 * all[std::min(size_t(p * all.size()), all.size() - 1)]; };
+		std::cout << readerSize << " readers, " << personSize << " persons: " << all.size() << "/" << readerSize * frameSize
+			<< " frames read, latency p50 " << Percentile(0.5) << "us, p99 " << Percentile(0.99) << "us, max " << Percentile(1.)
+			<< "us, " << retryCnt << " retries" << (mismatchCnt > 0 ? ", MISMATCH" : "") << std::endl;
+	}
+}
+
+
+void BenchmarkSnapshot()
+{
+	for (const int readerSize : { 1, 4 })
+		for (const int personSize : { 4, 32 })
+			RunSnapshot(readerSize, personSize, 2000, 1e-3);
+}
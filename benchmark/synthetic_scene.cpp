@@ -0,0 +1,212 @@
+#include "synthetic_scene.h"
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <Eigen/Eigen>
+
+
+namespace
+{
+	// standing SKEL19 skeleton facing +y, feet on the floor
+	Eigen::Matrix3Xf MakeTemplate()
+	{
+		Eigen::Matrix3Xf joints(3, 19);
+		joints << 0.f, 0.f, 0.1f, -0.1f, 0.f, 0.2f, -0.2f, 0.1f, -0.1f, 0.04f, -0.04f, 0.25f, -0.25f, 0.1f, -0.1f, 0.27f, -0.27f, -0.1f, 0.1f,
+			0.f, 0.f, 0.f, 0.f, 0.05f, 0.f, 0.f, 0.02f, 0.02f, 0.08f, 0.08f, 0.f, 0.f, 0.f, 0.f, 0.05f, 0.05f, 0.12f, 0.12f,
+			0.95f, 1.5f, 0.95f, 0.95f, 1.65f, 1.45f, 1.45f, 0.5f, 0.5f, 1.7f, 1.7f, 1.15f, 1.15f, 0.08f, 0.08f, 0.9f, 0.9f, 0.02f, 0.02f;
+		return joints;
+	}
+}
+
+
+SyntheticRig MakeRig(const int& camSize)
+{
+	const int siteSize = (camSize + 4) / 5;
+	const int colSize = int(std::ceil(std::sqrt(float(siteSize))));
+	const float spacing = 9.f;
+	SyntheticRig rig;
+	for (int view = 0; view < camSize; view++) {
+		const int site = view / 5;
+		const Eigen::Vector3f center(spacing * float(site % colSize), spacing * float(site / colSize), 0.f);
+		const float angle = 2.f * float(EIGEN_PI) * float(view % 5) / 5.f + float(site);
+		const Eigen::Vector3f dir(std::cos(angle), std::sin(angle), 0.f);
+		Camera cam;
+		cam.imgSize = cv::Size(1920, 1080);
+		cam.eiK << 1200.f, 0.f, 960.f, 0.f, 1200.f, 540.f, 0.f, 0.f, 1.f;
+		cam.LookAt(center + 4.5f * dir + Eigen::Vector3f(0.f, 0.f, 5.f), center, Eigen::Vector3f::UnitZ());
+		char name[16];
+		std::snprintf(name, sizeof(name), "cam%03d", view);
+		rig.cams.insert(std::make_pair(std::string(name), cam));
+		rig.sites.emplace_back(site);
+	}
+
+	rig.centers.resize(3, siteSize);
+	for (int site = 0; site < siteSize; site++)
+		rig.centers.col(site) = Eigen::Vector3f(spacing * float(site % colSize), spacing * float(site / colSize), 0.f);
+
+	const float margin = spacing / 2.f;
+	rig.volumeMin = Eigen::Vector3f(-margin, -margin, 0.f);
+	rig.volumeMax = Eigen::Vector3f(spacing * float(std::min(siteSize, colSize) - 1) + margin,
+		spacing * float((siteSize - 1) / colSize) + margin, 2.f);
+	return rig;
+}
+
+
+SyntheticScene MakeScene(const SyntheticRig& rig, const int& personSize, std::mt19937& rng)
+{
+	static const Eigen::Matrix3Xf skelTemplate = MakeTemplate();
+	std::uniform_real_distribution<float> uniform(0.f, 1.f);
+	std::vector<Eigen::Matrix3Xf> skels3d;
+	for (int pIdx = 0; pIdx < personSize; pIdx++) {
+		const Eigen::Matrix3f rot = Eigen::AngleAxisf(2.f * float(EIGEN_PI) * uniform(rng), Eigen::Vector3f::UnitZ()).toRotationMatrix();
+		const int site = std::min(int(uniform(rng) * float(rig.centers.cols())), int(rig.centers.cols()) - 1);
+		const float radius = 3.5f * std::sqrt(uniform(rng));
+		const float angle = 2.f * float(EIGEN_PI) * uniform(rng);
+		const Eigen::Vector3f pos = rig.centers.col(site) + radius * Eigen::Vector3f(std::cos(angle), std::sin(angle), 0.f);
+		skels3d.emplace_back((rot * skelTemplate).colwise() + pos);
+	}
+	return RenderScene(rig, skels3d, rng);
+}
+
+
+SyntheticScene RenderScene(const SyntheticRig& rig, const std::vector<Eigen::Matrix3Xf>& skels3d, std::mt19937& rng)
+{
+	const SkelDef& def = GetSkelDef(SKEL19);
+	const std::map<std::string, Camera>& cams = rig.cams;
+	const int personSize = int(skels3d.size());
+	std::normal_distribution<float> noise(0.f, 1.f);
+
+	SyntheticScene scene;
+	scene.skels3d = skels3d;
+	scene.detections.assign(cams.size(), OpenposeDetection(SKEL19));
+	scene.owners.assign(cams.size(), std::vector<std::vector<int>>(def.jointSize));
+	int view = 0;
+	for (auto camIter = cams.begin(); camIter != cams.end(); camIter++, view++) {
+		const Camera& cam = camIter->second;
+		OpenposeDetection& detection = scene.detections[view];
+		detection.state = DETECTION_PIXEL;
+		std::vector<std::vector<int>>& owners = scene.owners[view];
+		for (int jIdx = 0; jIdx < def.jointSize; jIdx++) {
+			std::vector<Eigen::Vector3f> joints;
+			for (int pIdx = 0; pIdx < personSize; pIdx++) {
+				const Eigen::Vector3f xyz = cam.eiProj * scene.skels3d[pIdx].col(jIdx).homogeneous();
+				if (xyz.z() < FLT_EPSILON)
+					continue;
+				const Eigen::Vector2f uv = xyz.hnormalized() + Eigen::Vector2f(noise(rng), noise(rng));
+				if (uv.x() >= 0.f && uv.x() < float(cam.imgSize.width) && uv.y() >= 0.f && uv.y() < float(cam.imgSize.height)) {
+					joints.emplace_back(Eigen::Vector3f(uv.x(), uv.y(), 0.9f));
+					owners[jIdx].emplace_back(pIdx);
+				}
+			}
+			detection.joints[jIdx].resize(3, joints.size());
+			for (int i = 0; i < joints.size(); i++)
+				detection.joints[jIdx].col(i) = joints[i];
+		}
+
+		for (int pafIdx = 0; pafIdx < def.pafSize; pafIdx++) {
+			const std::vector<int>& ownersA = owners[def.pafDict(0, pafIdx)];
+			const std::vector<int>& ownersB = owners[def.pafDict(1, pafIdx)];
+			detection.pafs[pafIdx].setZero(ownersA.size(), ownersB.size());
+			for (int a = 0; a < ownersA.size(); a++)
+				for (int b = 0; b < ownersB.size(); b++)
+					if (ownersA[a] == ownersB[b])
+						detection.pafs[pafIdx](a, b) = 0.9f;
+		}
+	}
+	return scene;
+}
+
+
+std::vector<std::vector<Eigen::Matrix3Xf>> MakeRun(const SyntheticRig& rig, const std::vector<float>& speeds,
+	const int& frameSize, const float& fps, std::mt19937& rng)
+{
+	static const Eigen::Matrix3Xf skelTemplate = MakeTemplate();
+	const float radius = 3.5f;
+	std::uniform_real_distribution<float> uniform(0.f, 1.f);
+	std::normal_distribution<float> noise(0.f, 1.f);
+	std::vector<Eigen::Vector3f> positions;
+	std::vector<float> headings;
+	for (int pIdx = 0; pIdx < speeds.size(); pIdx++) {
+		const float angle = 2.f * float(EIGEN_PI) * uniform(rng);
+		positions.emplace_back(radius * std::sqrt(uniform(rng)) * Eigen::Vector3f(std::cos(angle), std::sin(angle), 0.f));
+		headings.emplace_back(2.f * float(EIGEN_PI) * uniform(rng));
+	}
+
+	std::vector<std::vector<Eigen::Matrix3Xf>> skels(frameSize);
+	for (int frameIdx = 0; frameIdx < frameSize; frameIdx++) {
+		for (int pIdx = 0; pIdx < speeds.size(); pIdx++) {
+			headings[pIdx] += 0.1f * noise(rng);
+			Eigen::Vector3f dir(std::cos(headings[pIdx]), std::sin(headings[pIdx]), 0.f);
+			// head back to the center when about to leave the site
+			if ((positions[pIdx] + speeds[pIdx] / fps * dir).norm() > radius && positions[pIdx].dot(dir) > 0.f) {
+				dir = (-positions[pIdx]).normalized();
+				headings[pIdx] = std::atan2(dir.y(), dir.x());
+			}
+			positions[pIdx] += speeds[pIdx] / fps * dir;
+			// the template faces +y, turn it to the heading
+			const Eigen::Matrix3f rot = Eigen::AngleAxisf(headings[pIdx] - float(EIGEN_PI) / 2.f, Eigen::Vector3f::UnitZ()).toRotationMatrix();
+			skels[frameIdx].emplace_back((rot * skelTemplate).colwise() + (rig.centers.col(0) + positions[pIdx]));
+		}
+	}
+	return skels;
+}
+
+
+std::vector<int> SyntheticScene::CountOwners(const Eigen::Matrix3Xf& skel2d) const
+{
+	const int jointSize = GetSkelDef(SKEL19).jointSize;
+	std::vector<int> cnts(skels3d.size(), 0);
+	for (int view = 0; view < detections.size(); view++) {
+		for (int jIdx = 0; jIdx < jointSize; jIdx++) {
+			const Eigen::Vector3f joint = skel2d.col(view * jointSize + jIdx);
+			if (joint.z() < FLT_EPSILON)
+				continue;
+			const Eigen::Matrix3Xf& candis = detections[view].joints[jIdx];
+			for (int jCandiIdx = 0; jCandiIdx < candis.cols(); jCandiIdx++)
+				if (candis.col(jCandiIdx) == joint)
+					cnts[owners[view][jIdx][jCandiIdx]]++;
+		}
+	}
+	return cnts;
+}
+
+
+void SyntheticScene::Evaluate(const std::map<int, Eigen::Matrix3Xf>& skels2d, float& purity, float& completeness) const
+{
+	int assignedCnt = 0, pureCnt = 0, detectedCnt = 0;
+	std::vector<int> bestCnts(skels3d.size(), 0);
+	for (const auto& skel2d : skels2d) {
+		const std::vector<int> cnts = CountOwners(skel2d.second);
+		for (int pIdx = 0; pIdx < skels3d.size(); pIdx++)
+			bestCnts[pIdx] = std::max(bestCnts[pIdx], cnts[pIdx]);
+		for (const int& cnt : cnts)
+			assignedCnt += cnt;
+		pureCnt += cnts.empty() ? 0 : *std::max_element(cnts.begin(), cnts.end());
+	}
+
+	for (const auto& viewOwners : owners)
+		for (const auto& jointOwners : viewOwners)
+			detectedCnt += int(jointOwners.size());
+	int completeCnt = 0;
+	for (const int& cnt : bestCnts)
+		completeCnt += cnt;
+	purity = float(pureCnt) / float(std::max(assignedCnt, 1));
+	completeness = float(completeCnt) / float(std::max(detectedCnt, 1));
+}
+
+
+std::vector<int> SyntheticScene::Identify(const std::map<int, Eigen::Matrix3Xf>& skels2d) const
+{
+	std::vector<int> identities(skels3d.size(), -1);
+	std::vector<int> bestCnts(skels3d.size(), 0);
+	for (const auto& skel2d : skels2d) {
+		const std::vector<int> cnts = CountOwners(skel2d.second);
+		for (int pIdx = 0; pIdx < skels3d.size(); pIdx++) {
+			if (cnts[pIdx] > bestCnts[pIdx]) {
+				bestCnts[pIdx] = cnts[pIdx];
+				identities[pIdx] = skel2d.first;
+			}
+		}
+	}
+	return identities;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <map>
+#include <random>
+#include "../src/camera.h"
+#include "../src/openpose.h"
+
+
+// a wide area rig of sites 9 metres apart on a grid, each with 5 cameras around it looking at its center. cameras
+// share their view with the rest of their site and a little with the neighbour sites
+struct SyntheticRig
+{
+	std::map<std::string, Camera> cams;
+	std::vector<int> sites;					// sites[view]
+	Eigen::Matrix3Xf centers;				// centers.col(site)
+	Eigen::Vector3f volumeMin, volumeMax;
+};
+
+SyntheticRig MakeRig(const int& camSize);
+
+
+// SKEL19 persons standing at random places around the sites and their detections in every camera seeing them. pafs only
+// join the joints of the same person
+struct SyntheticScene
+{
+	std::vector<Eigen::Matrix3Xf> skels3d;
+	std::vector<OpenposeDetection> detections;
+	std::vector<std::vector<std::vector<int>>> owners;		// owners[view][jIdx][jCandiIdx] = person
+
+	// purity: associated joints belonging to the person most of their skeleton belongs to. completeness: detected
+	// joints ending up in the skeleton of their person
+	void Evaluate(const std::map<int, Eigen::Matrix3Xf>& skels2d, float& purity, float& completeness) const;
+
+	// identity of every person, the one holding most of its joints or -1
+	std::vector<int> Identify(const std::map<int, Eigen::Matrix3Xf>& skels2d) const;
+
+private:
+	std::vector<int> CountOwners(const Eigen::Matrix3Xf& skel2d) const;
+};
+
+SyntheticScene MakeScene(const SyntheticRig& rig, const int& personSize, std::mt19937& rng);
+SyntheticScene RenderScene(const SyntheticRig& rig, const std::vector<Eigen::Matrix3Xf>& skels3d, std::mt19937& rng);
+
+// persons of the first site running at the given speeds in m/s, each heading on a random walk and turning back at
+// the edge of the site. skels[frameIdx][pIdx]
+std::vector<std::vector<Eigen::Matrix3Xf>> MakeRun(const SyntheticRig& rig, const std::vector<float>& speeds,
+	const int& frameSize, const float& fps, std::mt19937& rng);
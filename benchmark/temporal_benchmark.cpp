@@ -0,0 +1,88 @@
+#include "benchmark.h"
+#include "../src/kruskal_associater.h"
+#include "../src/skel_updater.h"
+#include "../src/detection_stream.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+
+namespace
+{
+	// detected joints of the reference associated alike, each person compared under its identity
+	void CountAgreement(const std::map<int, Eigen::Matrix3Xf>& skels2d, const std::map<int, Eigen::Matrix3Xf>& ref, int& agreeCnt, int& refCnt)
+	{
+		for (const auto& refSkel : ref) {
+			const auto iter = skels2d.find(refSkel.first);
+			for (int col = 0; col < refSkel.second.cols(); col++) {
+				if (refSkel.second(2, col) > 0.f) {
+					refCnt++;
+					if (iter != skels2d.end() && iter->second.col(col) == refSkel.second.col(col))
+						agreeCnt++;
+				}
+			}
+		}
+	}
+}
+
+
+void BenchmarkTemporal()
+{
+	const ShelfData shelf = LoadShelf();
+
+	// the full search tracks the sequence, the fast path then replays the same inputs
+	KruskalAssociater associater(SKEL19, shelf.cams);
+	SetShelfParams(associater);
+	SkelTriangulateUpdater skelUpdater(SKEL19);
+	skelUpdater.SetTriangulateThresh(0.05f);
+	skelUpdater.SetMinTrackCnt(5);
+
+	DetectionStream detectionStream(shelf.filenames, shelf.preprocess);
+	std::vector<std::vector<OpenposeDetection>> frames;
+	std::vector<std::map<int, Eigen::Matrix4Xf>> skels3dPrev;
+	std::vector<std::map<int, Eigen::Matrix3Xf>> skels2d;
+	std::vector<OpenposeDetection> detections;
+	long long cliqueCnt = 0;
+	Timer timer;
+	double time = 0.;
+	while (detectionStream.Read(detections)) {
+		frames.emplace_back(detections);
+		skels3dPrev.emplace_back(skelUpdater.GetSkel3d());
+		associater.SetDetections(std::move(detections));
+		associater.SetSkels3dPrev(skels3dPrev.back());
+		timer.Reset();
+		associater.Associate();
+		time += timer.Elapsed();
+		cliqueCnt += associater.GetCliqueCnt();
+		skels2d.emplace_back(associater.GetSkels2d());
+		skelUpdater.Update(associater.GetSkels2d(), shelf.projs);
+	}
+	std::cout << std::setw(16) << "full search" << ": " << double(cliqueCnt) / frames.size() << " cliques, "
+		<< 1e3 * time / frames.size() << "ms per frame" << std::endl;
+
+	for (const float minClaimRatio : { 1.f, 0.9f, 0.8f, 0.6f }) {
+		KruskalAssociater fast(SKEL19, shelf.cams);
+		SetShelfParams(fast);
+		fast.SetTemporalFastPath(true);
+		fast.SetMinClaimRatio(minClaimRatio);
+		long long cliqueCnt = 0;
+		int equalCnt = 0, agreeCnt = 0, refCnt = 0;
+		double time = 0., fastPathRatio = 0.;
+		for (int frameIdx = 0; frameIdx < frames.size(); frameIdx++) {
+			fast.SetDetections(frames[frameIdx]);
+			fast.SetSkels3dPrev(skels3dPrev[frameIdx]);
+			timer.Reset();
+			fast.Associate();
+			time += timer.Elapsed();
+			cliqueCnt += fast.GetCliqueCnt();
+			fastPathRatio += fast.GetFastPathRatio();
+			const int prevAgreeCnt = agreeCnt, prevRefCnt = refCnt;
+			CountAgreement(fast.GetSkels2d(), skels2d[frameIdx], agreeCnt, refCnt);
+			equalCnt += agreeCnt - prevAgreeCnt == refCnt - prevRefCnt && fast.GetSkels2d().size() == skels2d[frameIdx].size() ? 1 : 0;
+		}
+		std::cout << std::setw(16) << "min claim " + std::to_string(minClaimRatio).substr(0, 3) << ": "
+			<< double(cliqueCnt) / frames.size() << " cliques, " << 1e3 * time / frames.size() << "ms per frame, "
+			<< 100. * fastPathRatio / frames.size() << "% of tracked persons fast pathed, " << 100. * agreeCnt / std::max(refCnt, 1)
+			<< "% of joints and " << equalCnt << " frames equal to full search" << std::endl;
+	}
+}
@@ -0,0 +1,44 @@
+#include "benchmark.h"
+#include "synthetic_scene.h"
+#include "../src/kruskal_associater.h"
+#include <iostream>
+#include <iomanip>
+
+
+void BenchmarkView()
+{
+	// the rig grows by sites, so cameras of different sites share little of the volume
+	const int frameSize = 10;
+	for (const int camSize : { 5, 10, 20, 40 }) {
+		const SyntheticRig rig = MakeRig(camSize);
+		std::mt19937 rng(camSize);
+		std::vector<SyntheticScene> scenes;
+		for (int frameIdx = 0; frameIdx < frameSize; frameIdx++)
+			scenes.emplace_back(MakeScene(rig, camSize, rng));
+
+		for (const float minViewOverlap : { 0.f, 0.1f, 0.3f }) {
+			KruskalAssociater associater(SKEL19, rig.cams);
+			SetSyntheticParams(associater);
+			associater.SetWorkingVolume(rig.volumeMin, rig.volumeMax);
+			associater.SetMinViewOverlap(minViewOverlap);
+
+			Timer timer;
+			double time = 0.;
+			float puritySum = 0.f, completenessSum = 0.f;
+			for (const SyntheticScene& scene : scenes) {
+				associater.SetDetections(scene.detections);
+				associater.SetSkels3dPrev(std::map<int, Eigen::Matrix4Xf>());
+				timer.Reset();
+				associater.Associate();
+				time += timer.Elapsed();
+				float purity, completeness;
+				scene.Evaluate(associater.GetSkels2d(), purity, completeness);
+				puritySum += purity;
+				completenessSum += completeness;
+			}
+			std::cout << std::setw(2) << camSize << " views, min overlap " << minViewOverlap << ": " << associater.GetViewPairCnt()
+				<< " view pairs, " << 1e3 * time / frameSize << "ms per frame, " << associater.GetCliqueCnt() << " cliques in the last, purity "
+				<< puritySum / frameSize << ", completeness " << completenessSum / frameSize << std::endl;
+		}
+	}
+}
@@ -0,0 +1,77 @@
+#include "../src/openpose.h"
+#include "../src/camera.h"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+
+// convert a text detection file ("SkelType frameSize" layout) to the binary detection file,
+// with a calibration the frames are cached preprocessed (SKEL19, pixel coordinates, normalized pafs) as the associater consumes them
+bool Convert(const std::string& src, const std::string& dst, const std::map<std::string, Camera>& cams)
+{
+	auto start = std::chrono::steady_clock::now();
+	std::vector<OpenposeDetection> detections = ParseDetections(src);
+	const float parseTime = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	if (!cams.empty()) {
+		const auto iter = cams.find(std::filesystem::path(src).stem().string());
+		if (iter == cams.end()) {
+			std::cerr << "no camera for: " << src << std::endl;
+			return false;
+		}
+		DetectionPreprocess preprocess;
+		preprocess.type = SKEL19;
+		preprocess.imgSizes = { iter->second.imgSize };
+		preprocess.normalizePaf = true;
+#pragma omp parallel for
+		for (int frameIdx = 0; frameIdx < detections.size(); frameIdx++)
+			preprocess.Apply(0, detections[frameIdx]);
+	}
+	SerializeDetectionFile(detections, dst);
+
+	start = std::chrono::steady_clock::now();
+	const DetectionFile file(dst);
+	bool equal = file.GetFrameSize() == detections.size() && (detections.empty()
+		|| (file.GetType() == detections.begin()->type && file.GetState() == detections.begin()->state));
+	for (int frameIdx = 0; frameIdx < file.GetFrameSize() && equal; frameIdx++) {
+		const OpenposeDetection detection = file.GetDetection(frameIdx);
+		for (int jIdx = 0; jIdx < detection.joints.size() && equal; jIdx++)
+			equal = detection.joints[jIdx] == detections[frameIdx].joints[jIdx];
+		for (int pafIdx = 0; pafIdx < detection.pafs.size() && equal; pafIdx++)
+			equal = detection.pafs[pafIdx] == detections[frameIdx].pafs[pafIdx];
+	}
+	const float loadTime = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << src << " -> " << dst << ": " << detections.size() << " frames, text " << parseTime
+		<< "s, binary " << loadTime << "s" << (equal ? "" : ", MISMATCH") << std::endl;
+	return equal;
+}
+
+
+int main(int argc, char** argv)
+{
+	// files are named by camera serial, so the calibration gives the pixel scale of each one
+	std::map<std::string, Camera> cams;
+	if (argc >= 3 && std::string(argv[1]) == "--preprocess") {
+		cams = ParseCameras(argv[2]);
+		argc -= 2;
+		argv += 2;
+	}
+
+	if (argc == 2 && std::filesystem::is_directory(argv[1])) {
+		bool success = true;
+		for (const auto& entry : std::filesystem::directory_iterator(argv[1]))
+			if (entry.path().extension() == ".txt")
+				success &= Convert(entry.path().string(), std::filesystem::path(entry.path()).replace_extension(".bin").string(), cams);
+		return success ? 0 : 1;
+	}
+	else if (argc >= 3 && argc % 2 == 1) {
+		bool success = true;
+		for (int i = 1; i < argc; i += 2)
+			success &= Convert(argv[i], argv[i + 1], cams);
+		return success ? 0 : 1;
+	}
+
+	std::cerr << "usage: convert_detection [--preprocess <calibration.json>] <detection dir>" << std::endl
+		<< "       convert_detection [--preprocess <calibration.json>] <src.txt> <dst.bin> [<src.txt> <dst.bin> ...]" << std::endl;
+	return 1;
+}
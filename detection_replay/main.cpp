@@ -0,0 +1,57 @@
+#include "../src/detection_ring.h"
+#include "../src/detection_stream.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+
+// stand-in for a live detector: publishes the frames of per-view detection files to a shared memory ring at a fixed rate
+int main(int argc, char** argv)
+{
+	bool lossless = false;
+	if (argc > 1 && std::string(argv[1]) == "--lossless") {
+		lossless = true;
+		argc--;
+		argv++;
+	}
+	if (argc < 4) {
+		std::cerr << "usage: detection_replay [--lossless] <ring name> <fps> <detection file> [<detection file> ...]" << std::endl
+			<< "       --lossless waits for the consumer instead of dropping frames when the ring is full" << std::endl;
+		return 1;
+	}
+
+	const std::string name = argv[1];
+	const float fps = std::stof(argv[2]);
+	const std::vector<std::string> filenames(argv + 3, argv + argc);
+	DetectionStream detectionStream(filenames);
+	std::vector<OpenposeDetection> detections;
+
+	DetectionRingWriter writer;
+	bool created = false;
+	const auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(fps > 0.f ? 1.0 / fps : 0.0));
+	auto next = std::chrono::steady_clock::now();
+	int frameIdx = 0;
+	for (; detectionStream.Read(detections); frameIdx++) {
+		if (!created) {
+			if (!writer.Create(name, detections.begin()->type, int(detections.size()))) {
+				std::cerr << "can not create ring: " << name << std::endl;
+				return 1;
+			}
+			created = true;
+		}
+
+		std::this_thread::sleep_until(next);
+		next += interval;
+		while (lossless && writer.IsFull())
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		// steady clock is system wide, so consumers can measure the ingest latency from it
+		const double timestamp = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		writer.Write(detections, timestamp);
+	}
+
+	std::cout << name << ": " << frameIdx << " frames, " << writer.GetDropCnt() << " dropped" << std::endl;
+	writer.Close();
+	return 0;
+}
@@ -2,12 +2,14 @@
 #include "../src/skel_updater.h"
 #include "../src/skel_painter.h"
 #include "../src/hungarian_algorithm.h"
+#include "../src/detection_stream.h"
 #include <opencv2/opencv.hpp>
 #include <json/json.h>
 
 
 // #define SAVE_RESULT
 #define RUN_OLD_VERSION
+#define PREDICT_MOTION			// gate the temporal edges around the predicted skeletons at their prediction errors
 
 
 Eigen::Matrix4Xf MappingToShelf(const Eigen::Matrix4Xf& skel19)
@@ -47,7 +49,7 @@ Eigen::VectorXi Evaluate(const Eigen::Matrix4Xf& shelfSkel, const Eigen::Matrix4
 }
 
 
-void PrintEvaluation(const std::vector<Eigen::VectorXi>& correctJCnt) {
+float PrintEvaluation(const std::vector<Eigen::VectorXi>& correctJCnt) {
 	Eigen::VectorXi sum = Eigen::VectorXi::Zero(correctJCnt.begin()->size());
 	for (const auto& c : correctJCnt)
 		sum += c;
@@ -62,6 +64,7 @@ void PrintEvaluation(const std::vector<Eigen::VectorXi>& correctJCnt) {
 		std::cout << pafName[i] << ": " << sum[i] << "/" << correctJCnt.size() << " " << rate[i] << std::endl;
 
 	std::cout << "Average:" << rate.sum() / rate.size() << std::endl;
+	return rate.sum() / rate.size();
 }
 
 
@@ -72,25 +75,26 @@ int main()
 	Eigen::Matrix3Xf projs(3, cams.size() * 4);
 	std::vector<cv::VideoCapture> videos(cams.size());
 	std::vector<cv::Mat> rawImgs(cams.size());
-	std::vector<std::vector<OpenposeDetection>> seqDetections(cams.size());
+	std::vector<cv::Size> imgSizes(cams.size());
+	std::vector<std::string> detectionFiles(cams.size());
 	std::vector<std::map<int, Eigen::Matrix4Xf>> gt = ParseSkels("../data/shelf/gt.txt");
-	std::vector<std::map<int, Eigen::Matrix4Xf>> skels;
+	SkelFileWriter skelWriter("../data/shelf/skel.bin", GetSkelDef(SKEL19).jointSize);
 
 #pragma omp parallel for
 	for (int i = 0; i < cams.size(); i++) {
 		auto iter = std::next(cams.begin(), i);
 		videos[i] = cv::VideoCapture("../data/shelf/video/" + iter->first + ".mp4");
 		projs.middleCols(4 * i, 4) = iter->second.eiProj;
-		seqDetections[i] = ParseDetections("../data/shelf/detection/" + iter->first + ".txt");
-		cv::Size imgSize(int(videos[i].get(cv::CAP_PROP_FRAME_WIDTH)), int(videos[i].get(cv::CAP_PROP_FRAME_HEIGHT)));
-		for (auto&&detection : seqDetections[i]) {
-			for (auto&& joints : detection.joints) {
-				joints.row(0) *= (imgSize.width - 1);
-				joints.row(1) *= (imgSize.height - 1);
-			}
-		}
-		rawImgs[i].create(imgSize, CV_8UC3);
+		detectionFiles[i] = "../data/shelf/detection/" + iter->first + ".txt";
+		imgSizes[i] = cv::Size(int(videos[i].get(cv::CAP_PROP_FRAME_WIDTH)), int(videos[i].get(cv::CAP_PROP_FRAME_HEIGHT)));
+		rawImgs[i].create(imgSizes[i], CV_8UC3);
 	}
+	DetectionPreprocess preprocess;
+	preprocess.type = SKEL19;
+	preprocess.imgSizes = imgSizes;
+	preprocess.normalizePaf = true;				// same as associater.SetNormalizeEdge
+	DetectionStream detectionStream(detectionFiles, preprocess);
+	std::vector<OpenposeDetection> detections;
 
 	KruskalAssociater associater(SKEL19, cams);
 	associater.SetMaxTempDist(0.2f);
@@ -132,17 +136,22 @@ int main()
 	shelfPainter.rate = 0.5f;
 
 	std::map<int, std::vector<Eigen::VectorXi>> correctJCnt;
+	std::map<int, int> gtTracks;				// gtTracks[gt identity], tracked identity last matched to it
+	int switchCnt = 0;
 	// process sequence
-	for (int frameIdx = 0; frameIdx < seqDetections.begin()->size(); frameIdx++) {
-		for (int view = 0; view < cams.size(); view++) {
+	for (int frameIdx = 0; detectionStream.Read(detections); frameIdx++) {
+		for (int view = 0; view < cams.size(); view++)
 			videos[view] >> rawImgs[view];
-			associater.SetDetection(view, seqDetections[view][frameIdx].Mapping(SKEL19));
-		}
 
+		associater.SetDetections(std::move(detections));
+#ifdef PREDICT_MOTION
+		associater.SetSkels3dPrev(skelUpdater.GetPredictedSkel3d(), skelUpdater.GetPredictionErrors());
+#else
 		associater.SetSkels3dPrev(skelUpdater.GetSkel3d());
+#endif
 		associater.Associate();
 		skelUpdater.Update(associater.GetSkels2d(), projs);
-		skels.emplace_back(skelUpdater.GetSkel3d());
+		skelWriter.Write(skelUpdater.GetSkel3d());
 
 		std::cout << std::to_string(frameIdx) << std::endl;
 
@@ -161,6 +170,13 @@ int main()
 			const auto gtIter = std::next(gt[frameIdx].begin(), matchPair.second.y());
 			const Eigen::VectorXi c = Evaluate(shelfIter->second, gtIter->second);
 			const int identity = gtIter->first;
+			auto trackIter = gtTracks.find(identity);
+			if (trackIter == gtTracks.end())
+				trackIter = gtTracks.insert(std::make_pair(identity, -shelfIter->first)).first;
+			else if (trackIter->second != -shelfIter->first) {
+				trackIter->second = -shelfIter->first;
+				switchCnt++;
+			}
 			auto iter = correctJCnt.find(identity);
 			if (iter == correctJCnt.end())
 				iter = correctJCnt.insert(std::make_pair(identity, std::vector<Eigen::VectorXi>())).first;
@@ -168,7 +184,6 @@ int main()
 		}
 
 #ifdef SAVE_RESULT
-		skels.emplace_back(skelUpdater.GetSkel3d());
 		const int layoutCols = 3;
 		cv::Mat detectImg, assocImg, reprojImg, gtImg;
 		std::vector<cv::Rect> rois = SkelPainter::MergeImgs(rawImgs, detectImg, layoutCols,
@@ -179,7 +194,7 @@ int main()
 
 #pragma omp parallel for
 		for (int view = 0; view < cams.size(); view++) {
-			const OpenposeDetection detection = seqDetections[view][frameIdx].Mapping(SKEL19);
+			const OpenposeDetection& detection = associater.GetDetections()[view];
 			skelPainter.DrawDetect(detection.joints, detection.pafs, detectImg(rois[view]));
 			for (const auto& skel2d : associater.GetSkels2d())
 				skelPainter.DrawAssoc(skel2d.second.middleCols(view * detection.joints.size(), detection.joints.size()), assocImg(rois[view]), skel2d.first);
@@ -202,11 +217,18 @@ int main()
 #endif
 
 	}
-	SerializeSkels(skels, "../data/shelf/skel.txt");
+	skelWriter.Close();
+	float pcpSum = 0.f;
 	for (const auto& pair : correctJCnt) {
 		std::cout << "identity: " << pair.first << std::endl;
-		PrintEvaluation(pair.second);
+		pcpSum += PrintEvaluation(pair.second);
 	}
+#ifdef PREDICT_MOTION
+	std::cout << "predicted temporal gate, ";
+#else
+	std::cout << "fixed temporal gate, ";
+#endif
+	std::cout << "PCP: " << pcpSum / std::max(int(correctJCnt.size()), 1) << ", id switches: " << switchCnt << std::endl;
 	system("pause");
 	return 0;
 }
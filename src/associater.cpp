@@ -10,10 +10,38 @@ Associater::Associater(const SkelType& type, const std::map<std::string, Camera>
 	const SkelDef& def = GetSkelDef(m_type);
 
 	m_detections.resize(m_cams.size());
-	m_assignMap.resize(m_cams.size(), std::vector<Eigen::VectorXi>(def.jointSize));
-	m_jointRays.resize(m_cams.size(), std::vector<Eigen::Matrix3Xf>(def.jointSize));
-	m_epiEdges.resize(def.jointSize, std::vector<std::vector<Eigen::MatrixXf>>(m_cams.size(), std::vector<Eigen::MatrixXf>(m_cams.size())));
-	m_tempEdges.resize(def.jointSize, std::vector<Eigen::MatrixXf>(m_cams.size()));
+	m_assignMap.resize(m_cams.size(), std::vector<std::vector<int>>(def.jointSize));
+	m_jointRays.resize(m_cams.size());
+	m_jointRayOffsets.resize(m_cams.size(), std::vector<int>(def.jointSize + 1, 0));
+	m_epiIndices.resize(m_cams.size(), std::vector<EpiBandIndex>(m_cams.size()));
+	for (auto camAIter = m_cams.begin(); camAIter != m_cams.end(); camAIter++)
+		for (auto camBIter = std::next(camAIter); camBIter != m_cams.end(); camBIter++)
+			m_epiIndices[std::distance(m_cams.begin(), camAIter)][std::distance(m_cams.begin(), camBIter)]
+			= EpiBandIndex(camAIter->second.eiPos, camBIter->second.eiPos);
+	m_epiEdges.resize(def.jointSize, std::vector<std::vector<EdgeGraph>>(m_cams.size(), std::vector<EdgeGraph>(m_cams.size())));
+	m_tempEdges.resize(def.jointSize, std::vector<EdgeGraph>(m_cams.size()));
+	CalcViewGraph();
+}
+
+
+void Associater::CalcViewGraph()
+{
+	// a pair shares the part of the volume seen by the view seeing less of it. without a volume every pair is kept
+	const bool sparse = m_minViewOverlap > 0.f && (m_volumeMax - m_volumeMin).minCoeff() > 0.f;
+	const Eigen::MatrixXf overlap = sparse ? CalcViewOverlap(m_cams, m_volumeMin, m_volumeMax) : Eigen::MatrixXf();
+	m_viewNeighbors.assign(m_cams.size(), std::vector<int>());
+	m_viewSuccessors.assign(m_cams.size(), std::vector<int>());
+	m_viewPairCnt = 0;
+	for (int viewA = 0; viewA < m_cams.size(); viewA++) {
+		for (int viewB = viewA + 1; viewB < m_cams.size(); viewB++) {
+			if (!sparse || std::max(overlap(viewA, viewB), overlap(viewB, viewA)) >= m_minViewOverlap) {
+				m_viewNeighbors[viewA].emplace_back(viewB);
+				m_viewNeighbors[viewB].emplace_back(viewA);
+				m_viewSuccessors[viewA].emplace_back(viewB);
+				m_viewPairCnt++;
+			}
+		}
+	}
 }
 
 
@@ -38,11 +66,11 @@ void Associater::Initialize()
 #pragma omp parallel for
 	for (int jIdx = 0; jIdx < def.jointSize; jIdx++)
 		for (int view = 0; view < m_cams.size(); view++)
-			m_assignMap[view][jIdx].setConstant(m_detections[view].joints[jIdx].cols(), -1);
+			m_assignMap[view][jIdx].assign(m_detections[view].joints[jIdx].cols(), -1);
 
-	m_personsMap.clear();
+	m_persons.Reset(def.jointSize, int(m_cams.size()));
 	for (int i = 0; i < m_skels3dPrev.size(); i++)
-		m_personsMap.insert(std::make_pair(i, Eigen::MatrixXi::Constant(GetSkelDef(m_type).jointSize, m_cams.size(), -1)));
+		m_persons.Insert(i);
 }
 
 
@@ -51,12 +79,24 @@ void Associater::CalcJointRays()
 	const SkelDef& def = GetSkelDef(m_type);
 #pragma omp parallel for
 	for (int view = 0; view < m_cams.size(); view++) {
-		const Camera& cam = std::next(m_cams.begin(), view)->second;
+		const Eigen::Matrix3f negRtKi = -std::next(m_cams.begin(), view)->second.eiRtKi;
+		std::vector<int>& offsets = m_jointRayOffsets[view];
+		for (int jIdx = 0; jIdx < def.jointSize; jIdx++)
+			offsets[jIdx + 1] = offsets[jIdx] + int(m_detections[view].joints[jIdx].cols());
+
+		// the buffer only grows, so it stops reallocating once the largest crowd has been seen
+		if (m_jointRays[view].cols() < offsets.back())
+			m_jointRays[view].resize(3, offsets.back());
+
+		// same as Camera::CalcRay for a whole joint at once, written without the homogeneous and colwise
+		// expressions since those evaluate into heap temporaries
 		for (int jIdx = 0; jIdx < def.jointSize; jIdx++) {
 			const Eigen::Matrix3Xf& joints = m_detections[view].joints[jIdx];
-			m_jointRays[view][jIdx].resize(3, joints.cols());
-			for (int jCandiIdx = 0; jCandiIdx < joints.cols(); jCandiIdx++)
-				m_jointRays[view][jIdx].col(jCandiIdx) = cam.CalcRay(joints.block<2, 1>(0, jCandiIdx));
+			auto rays = m_jointRays[view].middleCols(offsets[jIdx], joints.cols());
+			rays.noalias() = negRtKi.leftCols<2>() * joints.topRows<2>();
+			rays.colwise() += negRtKi.col(2);
+			for (int jCandiIdx = 0; jCandiIdx < rays.cols(); jCandiIdx++)
+				rays.col(jCandiIdx).normalize();
 		}
 	}
 }
@@ -67,20 +107,13 @@ void Associater::CalcPafEdges()
 	const SkelDef& def = GetSkelDef(m_type);
 	if (m_normalizeEdges) {
 #pragma omp parallel for
-		for (int pafIdx = 0; pafIdx < def.pafSize; pafIdx++) {
-			const Eigen::Vector2i jIdxPair = def.pafDict.col(pafIdx).transpose();
-			for (auto&& detection : m_detections) {
-				auto&& pafs = detection.pafs[pafIdx];
-				if (pafs.size() > 0) {
-					Eigen::VectorXf rowFactor = pafs.rowwise().sum().transpose().cwiseMax(1.f);
-					Eigen::VectorXf colFactor = pafs.colwise().sum().cwiseMax(1.f);
-					for (int i = 0; i < rowFactor.size(); i++)
-						pafs.row(i) /= rowFactor[i];
-					for (int i = 0; i < colFactor.size(); i++)
-						pafs.col(i) /= colFactor[i];
-				}
-			}
-		}
+		for (int pafIdx = 0; pafIdx < def.pafSize; pafIdx++)
+			for (auto&& detection : m_detections)
+				if (!(detection.state & DETECTION_PAF_NORMALIZED))
+					detection.NormalizePaf(pafIdx);
+
+		for (auto&& detection : m_detections)
+			detection.state |= DETECTION_PAF_NORMALIZED;
 	}
 }
 
@@ -90,38 +123,15 @@ void Associater::CalcEpiEdges()
 	const SkelDef& def = GetSkelDef(m_type);
 #pragma omp parallel for
 	for (int jIdx = 0; jIdx < def.jointSize; jIdx++) {
-		auto camAIter = m_cams.begin();
-		for (int viewA = 0; viewA < m_cams.size() - 1; viewA++, camAIter++) {
-			auto camBIter = std::next(camAIter);
-			for (int viewB = viewA + 1; viewB < m_cams.size(); viewB++, camBIter++) {
-				Eigen::MatrixXf& epi = m_epiEdges[jIdx][viewA][viewB];
-				const Eigen::Matrix3Xf& jointsA = m_detections[viewA].joints[jIdx];
-				const Eigen::Matrix3Xf& jointsB = m_detections[viewB].joints[jIdx];
-				const Eigen::Matrix3Xf& raysA = m_jointRays[viewA][jIdx];
-				const Eigen::Matrix3Xf& raysB = m_jointRays[viewB][jIdx];
-				if (jointsA.cols() > 0 && jointsB.cols() > 0) {
-					epi.setConstant(jointsA.cols(), jointsB.cols(), -1.f);
-					for (int jaCandiIdx = 0; jaCandiIdx < epi.rows(); jaCandiIdx++) {
-						for (int jbCandiIdx = 0; jbCandiIdx < epi.cols(); jbCandiIdx++) {
-							const float dist = Line2LineDist(
-								camAIter->second.eiPos, raysA.col(jaCandiIdx), camBIter->second.eiPos, raysB.col(jbCandiIdx));
-							if (dist < m_maxEpiDist)
-								epi(jaCandiIdx, jbCandiIdx) = 1.f - dist / m_maxEpiDist;
-						}
-					}
-
-					if (m_normalizeEdges) {
-						Eigen::VectorXf rowFactor = epi.rowwise().sum().transpose().cwiseMax(1.f);
-						Eigen::VectorXf colFactor = epi.colwise().sum().cwiseMax(1.f);
-						for (int i = 0; i < rowFactor.size(); i++)
-							epi.row(i) /= rowFactor[i];
-
-						for (int i = 0; i < colFactor.size(); i++)
-							epi.col(i) /= colFactor[i];
-					}
-					m_epiEdges[jIdx][viewB][viewA] = epi.transpose();
-
-				}
+		for (int viewA = 0; viewA < m_cams.size() - 1; viewA++) {
+			for (const int& viewB : m_viewSuccessors[viewA]) {
+				EdgeGraph& epi = m_epiEdges[jIdx][viewA][viewB];
+				const auto raysA = GetJointRays(viewA, jIdx);
+				const auto raysB = GetJointRays(viewB, jIdx);
+				if (raysA.cols() > 0 && raysB.cols() > 0)
+					m_epiIndices[viewA][viewB].CalcEpiEdge(raysA, raysB, m_maxEpiDist, m_normalizeEdges, epi);
+				else
+					epi.Clear(int(raysA.cols()), int(raysB.cols()));
 			}
 		}
 	}
@@ -135,70 +145,87 @@ void Associater::CalcTempEdges()
 	for (int jIdx = 0; jIdx < def.jointSize; jIdx++) {
 		auto camIter = m_cams.begin();
 		for (int view = 0; view < m_cams.size(); view++, camIter++) {
-			Eigen::MatrixXf& temp = m_tempEdges[jIdx][view];
-			const Eigen::Matrix3Xf& rays = m_jointRays[view][jIdx];
+			EdgeGraph& temp = m_tempEdges[jIdx][view];
+			const auto rays = GetJointRays(view, jIdx);
 			if (m_skels3dPrev.size() > 0 && rays.cols() > 0) {
-				temp.setConstant(m_skels3dPrev.size(), rays.cols(), -1.f);
+				thread_local std::vector<EdgeGraph::Edge> edges;
+				edges.clear();
 				int pIdx = 0;
 				for (auto skelIter = m_skels3dPrev.begin(); skelIter != m_skels3dPrev.end(); skelIter++, pIdx++) {
 					if (skelIter->second(3, jIdx) > FLT_EPSILON) {
-						for (int jCandiIdx = 0; jCandiIdx < temp.cols(); jCandiIdx++) {
+						const auto errorIter = m_prevErrors.find(skelIter->first);
+						const float maxDist = errorIter == m_prevErrors.end() ? m_maxTempDist
+							: std::min(std::max(m_tempGateScale * errorIter->second[jIdx], m_minTempDist), m_maxTempDist);
+						for (int jCandiIdx = 0; jCandiIdx < rays.cols(); jCandiIdx++) {
 							const float dist = Point2LineDist(skelIter->second.col(jIdx).head(3), camIter->second.eiPos, rays.col(jCandiIdx));
-							if (dist < m_maxTempDist)
-								temp(pIdx, jCandiIdx) = 1.f - dist / m_maxTempDist;
+							if (dist < maxDist)
+								edges.emplace_back(EdgeGraph::Edge{ pIdx, jCandiIdx, 1.f - dist / maxDist });
 						}
 					}
 				}
 
-				if (m_normalizeEdges) {
-					Eigen::VectorXf rowFactor = temp.rowwise().sum().transpose().cwiseMax(1.f);
-					Eigen::VectorXf colFactor = temp.colwise().sum().cwiseMax(1.f);
-					for (int i = 0; i < rowFactor.size(); i++)
-						temp.row(i) /= rowFactor[i];
-
-					for (int i = 0; i < colFactor.size(); i++)
-						temp.col(i) /= colFactor[i];
-				}
+				temp.Build(int(m_skels3dPrev.size()), int(rays.cols()), edges);
+				if (m_normalizeEdges)
+					temp.Normalize();
 			}
+			else
+				temp.Clear(int(m_skels3dPrev.size()), int(rays.cols()));
 		}
 	}
 }
 
 
+int Associater::GetTempEdgeCnt() const
+{
+	int cnt = 0;
+	for (const auto& jointEdges : m_tempEdges)
+		for (const EdgeGraph& edges : jointEdges)
+			cnt += edges.GetEdgeSize();
+	return cnt;
+}
+
+
 void Associater::CalcSkels2d()
 {
 	const SkelDef& def = GetSkelDef(m_type);
 
-	// filter person map
-	for (auto personIter = std::next(m_personsMap.begin(), m_skels3dPrev.size()); personIter != m_personsMap.end(); ) {
-		if ((personIter->second.array() >= 0).count() >= m_minAsgnCnt)
-			personIter++;
-		else {
+	// filter persons
+	for (int pIdx = m_persons.Next(int(m_skels3dPrev.size()) - 1); pIdx != m_persons.End(); pIdx = m_persons.Next(pIdx)) {
+		const PersonStore::Person person = m_persons[pIdx];
+		if ((person.array() >= 0).count() < m_minAsgnCnt) {
 			// erase
-			const Eigen::MatrixXi& person = personIter->second;
 			for (int view = 0; view < m_cams.size(); view++)
 				for (int jIdx = 0; jIdx < def.jointSize; jIdx++)
 					if (person(jIdx, view) != -1)
 						m_assignMap[view][jIdx][person(jIdx, view)] = -1;
-			personIter = m_personsMap.erase(personIter);
+			m_persons.Erase(pIdx);
 		}
 	}
 
 	// set identity
-	m_skels2d.clear();
-	for (const auto& person : m_personsMap) {
-		const int identity = person.first < m_skels3dPrev.size() ? std::next(m_skels3dPrev.begin(), person.first)->first
+	while (!m_skels2d.empty())
+		m_skels2dPool.emplace_back(m_skels2d.extract(m_skels2d.begin()));
+	for (int pIdx = m_persons.Begin(); pIdx != m_persons.End(); pIdx = m_persons.Next(pIdx)) {
+		const PersonStore::Person person = m_persons[pIdx];
+		const int identity = pIdx < m_skels3dPrev.size() ? std::next(m_skels3dPrev.begin(), pIdx)->first
 			: m_skels2d.empty() ? 0 : m_skels2d.rbegin()->first + 1;
-		Eigen::Matrix3Xf skel2d = Eigen::Matrix3Xf::Zero(3, m_cams.size() * def.jointSize);
+		Eigen::Matrix3Xf& skel2d = [&]() -> Eigen::Matrix3Xf& {
+			if (m_skels2dPool.empty())
+				return m_skels2d.insert(std::make_pair(identity, Eigen::Matrix3Xf())).first->second;
+			auto node = std::move(m_skels2dPool.back());
+			m_skels2dPool.pop_back();
+			node.key() = identity;
+			return m_skels2d.insert(std::move(node)).position->second;
+		}();
+		skel2d.setZero(3, m_cams.size() * def.jointSize);
 		for (int view = 0; view < m_cams.size(); view++) {
 			for (int jIdx = 0; jIdx < def.jointSize; jIdx++) {
-				const int index = person.second(jIdx, view); {
+				const int index = person(jIdx, view); {
 					if (index != -1)
 						skel2d.col(view * def.jointSize + jIdx) = m_detections[view].joints[jIdx].col(index);
 				}
 			}
 		}
-		m_skels2d.insert(std::make_pair(identity, skel2d));
 	}
 }
 
@@ -2,7 +2,8 @@
 #include "skel.h"
 #include "camera.h"
 #include "openpose.h"
-#include <list>
+#include "epi_kernel.h"
+#include "person_store.h"
 
 
 class Associater
@@ -10,38 +11,76 @@ class Associater
 public:
 	Associater(const SkelType& type, const std::map<std::string, Camera>& cams);
 	void SetDetections(const std::vector<OpenposeDetection>& detections) { m_detections = detections; }
+	void SetDetections(std::vector<OpenposeDetection>&& detections) { assert(detections.size() == m_cams.size());  m_detections = std::move(detections); }
 	void SetDetection(const int& view, const OpenposeDetection& detection) { assert(detection.type == m_type);  m_detections[view] = detection; }
+	void SetDetection(const int& view, OpenposeDetection&& detection) { assert(detection.type == m_type);  m_detections[view] = std::move(detection); }
 	void SetDetection(const std::string& serialNumber, const OpenposeDetection& detection) { SetDetection(std::distance(m_cams.begin(), m_cams.find(serialNumber)), detection); }
-	void SetSkels3dPrev(const std::map<int, Eigen::Matrix4Xf>& _skels3dPrev) { m_skels3dPrev = _skels3dPrev; }
+	void SetSkels3dPrev(const std::map<int, Eigen::Matrix4Xf>& _skels3dPrev) { m_skels3dPrev = _skels3dPrev; m_prevErrors.clear(); }
+	// predicted skeletons with the per joint error of their prediction, e.g. from SkelUpdater. the temporal gate of a
+	// joint is then its error times the gate scale, clamped to the min and max temp dist
+	void SetSkels3dPrev(const std::map<int, Eigen::Matrix4Xf>& _skels3dPrev, const std::map<int, Eigen::VectorXf>& _prevErrors) {
+		m_skels3dPrev = _skels3dPrev; m_prevErrors = _prevErrors; }
 	const std::map<int, Eigen::Matrix3Xf>& GetSkels2d() const { return m_skels2d; }
+	// candidates of the associated persons, the tracked persons first in the order of the previous skeletons
+	const PersonStore& GetPersons() const { return m_persons; }
 	const std::vector<OpenposeDetection>& GetDetections() const { return m_detections; }
+	// moves out the detections set last, the next frame has to set all of them again
+	std::vector<OpenposeDetection> TakeDetections() { return std::move(m_detections); }
+	OpenposeDetection TakeDetection(const int& view) { return std::move(m_detections[view]); }
 	const auto& GetCams()const { return m_cams; }
 	const SkelType& GetType() const { return m_type; }
 	void SetMaxEpiDist(const float& _maxEpiDist) { m_maxEpiDist = _maxEpiDist; }
 	void SetMaxTempDist(const float& _maxTempDist) { m_maxTempDist = _maxTempDist; }
+	void SetMinTempDist(const float& _minTempDist) { m_minTempDist = _minTempDist; }
+	void SetTempGateScale(const float& _tempGateScale) { m_tempGateScale = _tempGateScale; }
+	int GetTempEdgeCnt() const;		// joint temporal edges of the last frame
 	void SetMinAsgnCnt(const int& _minAsgnCnt) { m_minAsgnCnt = _minAsgnCnt; }
 	void SetNormalizeEdge(const bool& _normalizeEdges) { m_normalizeEdges = _normalizeEdges; }
+
+	// views sharing less than the min overlap of the working volume box are not paired, all views are by default
+	void SetWorkingVolume(const Eigen::Vector3f& volumeMin, const Eigen::Vector3f& volumeMax) { m_volumeMin = volumeMin; m_volumeMax = volumeMax; CalcViewGraph(); }
+	void SetMinViewOverlap(const float& _minViewOverlap) { m_minViewOverlap = _minViewOverlap; CalcViewGraph(); }
+	int GetViewPairCnt() const { return m_viewPairCnt; }
 	virtual void Associate() = 0;
 
 protected:
 	float m_maxEpiDist = 0.2f;
 	float m_maxTempDist = 0.5f;
+	float m_minTempDist = 0.1f;
+	float m_tempGateScale = 3.f;
 	int m_minAsgnCnt = 5;
 	bool m_normalizeEdges = true;
+	Eigen::Vector3f m_volumeMin = Eigen::Vector3f::Zero();
+	Eigen::Vector3f m_volumeMax = Eigen::Vector3f::Zero();
+	float m_minViewOverlap = 0.f;
 	SkelType m_type;
 	std::map<std::string, Camera> m_cams;
 	std::vector<OpenposeDetection> m_detections;
 
 	std::map<int, Eigen::Matrix4Xf> m_skels3dPrev;
+	std::map<int, Eigen::VectorXf> m_prevErrors;				// m_prevErrors[identity](jIdx), none gates at the max temp dist
 	std::map<int, Eigen::Matrix3Xf> m_skels2d;
+	std::vector<std::map<int, Eigen::Matrix3Xf>::node_type> m_skels2dPool;
 
-	std::vector<std::vector<Eigen::VectorXi>> m_assignMap;
-	std::map<int, Eigen::MatrixXi> m_personsMap;
-	std::vector<std::vector<Eigen::Matrix3Xf>> m_jointRays;
-	std::vector<std::vector<std::vector<Eigen::MatrixXf>>> m_epiEdges;	// m_epiEdge[jIdx][viewA][viewB](jaCandiIdx, jbCandiIdx)
-	std::vector<std::vector<Eigen::MatrixXf>> m_tempEdges;				// m_tempEdge[jIdx][view](pIdx, jCandiIdx)
+	// per frame memory of the association only grows and is reused by the next frame. skels2d are recycled through
+	// the pool, so their matrices keep their memory and a steady stream of frames does not allocate
+	std::vector<std::vector<std::vector<int>>> m_assignMap;		// m_assignMap[view][jIdx][jCandiIdx] = pIdx
+	PersonStore m_persons;										// m_persons[pIdx](jIdx, view) = jCandiIdx, tracked persons first
+	std::vector<Eigen::Matrix3Xf> m_jointRays;					// m_jointRays[view] holds the rays of all candidates joint by joint, grown only
+	std::vector<std::vector<int>> m_jointRayOffsets;			// m_jointRayOffsets[view][jIdx], first column of the joint in m_jointRays[view]
+	std::vector<std::vector<int>> m_viewNeighbors;				// m_viewNeighbors[view], the views paired with it ascending
+	std::vector<std::vector<int>> m_viewSuccessors;				// m_viewSuccessors[viewA], the views paired with it after it
+	int m_viewPairCnt = 0;
+	std::vector<std::vector<EpiBandIndex>> m_epiIndices;			// m_epiIndices[viewA][viewB], viewA < viewB
+	std::vector<std::vector<std::vector<EdgeGraph>>> m_epiEdges;		// m_epiEdge[jIdx][viewA][viewB](jaCandiIdx, jbCandiIdx), viewA < viewB
+	std::vector<std::vector<EdgeGraph>> m_tempEdges;					// m_tempEdge[jIdx][view](pIdx, jCandiIdx)
 
 	void Initialize();
+	void CalcViewGraph();
+	Eigen::Matrix3Xf::ConstColsBlockXpr GetJointRays(const int& view, const int& jIdx) const {
+		return m_jointRays[view].middleCols(m_jointRayOffsets[view][jIdx], m_jointRayOffsets[view][jIdx + 1] - m_jointRayOffsets[view][jIdx]); }
+	EdgeGraph::View GetEpiEdges(const int& jIdx, const int& viewA, const int& viewB) const {
+		return viewA < viewB ? m_epiEdges[jIdx][viewA][viewB].Rows() : m_epiEdges[jIdx][viewB][viewA].Cols(); }
 	void CalcJointRays();
 	void CalcPafEdges();
 	void CalcEpiEdges();
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <sstream>
+#include <algorithm>
 #include <Eigen/Eigen>
 #include <opencv2/calib3d.hpp>
 #include <opencv2/core/eigen.hpp>
@@ -199,6 +200,112 @@ std::map<std::string, Camera> ParseCameras(const std::string& jsonFile)
 }
 
 
+namespace
+{
+	// a grid of sampleSize^3 points in the box and their visibility: in front of the camera and projected into its image
+	Eigen::Matrix3Xf SampleVolume(const Eigen::Vector3f& volumeMin, const Eigen::Vector3f& volumeMax, const int& sampleSize)
+	{
+		Eigen::Matrix3Xf points(3, sampleSize * sampleSize * sampleSize);
+		for (int i = 0; i < points.cols(); i++) {
+			const Eigen::Vector3f t = (Eigen::Vector3f(float(i % sampleSize), float(i / sampleSize % sampleSize),
+				float(i / sampleSize / sampleSize)).array() + 0.5f) / float(sampleSize);
+			points.col(i) = volumeMin + t.cwiseProduct(volumeMax - volumeMin);
+		}
+		return points;
+	}
+
+
+	Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic> CalcVisibility(const std::map<std::string, Camera>& cameras, const Eigen::Matrix3Xf& points)
+	{
+		Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic> visible(points.cols(), cameras.size());
+		int view = 0;
+		for (auto camIter = cameras.begin(); camIter != cameras.end(); camIter++, view++) {
+			const Camera& cam = camIter->second;
+			for (int i = 0; i < points.cols(); i++) {
+				const Eigen::Vector3f xyz = cam.eiK * (cam.eiR * points.col(i) + cam.eiT);
+				visible(i, view) = xyz.z() > FLT_EPSILON && xyz.x() >= 0.f && xyz.x() < xyz.z() * float(cam.imgSize.width)
+					&& xyz.y() >= 0.f && xyz.y() < xyz.z() * float(cam.imgSize.height);
+			}
+		}
+		return visible;
+	}
+}
+
+
+Eigen::MatrixXf CalcViewOverlap(const std::map<std::string, Camera>& cameras, const Eigen::Vector3f& volumeMin,
+	const Eigen::Vector3f& volumeMax, const int& sampleSize)
+{
+	const Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic> visible = CalcVisibility(cameras, SampleVolume(volumeMin, volumeMax, sampleSize));
+	Eigen::MatrixXf overlap = Eigen::MatrixXf::Zero(cameras.size(), cameras.size());
+	for (int viewA = 0; viewA < cameras.size(); viewA++) {
+		const int cnt = int(visible.col(viewA).count());
+		for (int viewB = 0; viewB < cameras.size() && cnt > 0; viewB++)
+			overlap(viewA, viewB) = float((visible.col(viewA).array() && visible.col(viewB).array()).count()) / float(cnt);
+	}
+	return overlap;
+}
+
+
+std::vector<int> ClusterCameras(const std::map<std::string, Camera>& cameras, const Eigen::Vector3f& volumeMin,
+	const Eigen::Vector3f& volumeMax, const int& clusterSize, const int& sampleSize)
+{
+	// a camera is placed at the centroid of the samples it sees, cameras seeing nothing stay at their position
+	const Eigen::Matrix3Xf points = SampleVolume(volumeMin, volumeMax, sampleSize);
+	const Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic> visible = CalcVisibility(cameras, points);
+	Eigen::Matrix3Xf centers(3, cameras.size());
+	int view = 0;
+	for (auto camIter = cameras.begin(); camIter != cameras.end(); camIter++, view++) {
+		const int cnt = int(visible.col(view).count());
+		centers.col(view) = cnt > 0 ? Eigen::Vector3f((points * visible.col(view).cast<float>()) / float(cnt)) : camIter->second.eiPos;
+	}
+
+	// k-means seeded by the farthest point, deterministic for a rig
+	const int k = std::max(1, std::min(clusterSize, int(cameras.size())));
+	Eigen::Matrix3Xf means(3, k);
+	means.col(0) = centers.col(0);
+	Eigen::VectorXf minDists = (centers.colwise() - means.col(0)).colwise().norm().transpose();
+	for (int cluster = 1; cluster < k; cluster++) {
+		int farthest;
+		minDists.maxCoeff(&farthest);
+		means.col(cluster) = centers.col(farthest);
+		minDists = minDists.cwiseMin((centers.colwise() - means.col(cluster)).colwise().norm().transpose());
+	}
+
+	std::vector<int> clusters(cameras.size(), -1);
+	for (int iter = 0; iter < 100; iter++) {
+		bool changed = false;
+		for (int view = 0; view < cameras.size(); view++) {
+			int nearest;
+			(means.colwise() - centers.col(view)).colwise().squaredNorm().minCoeff(&nearest);
+			changed = changed || nearest != clusters[view];
+			clusters[view] = nearest;
+		}
+		if (!changed)
+			break;
+
+		Eigen::Matrix3Xf sums = Eigen::Matrix3Xf::Zero(3, k);
+		Eigen::VectorXi cnts = Eigen::VectorXi::Zero(k);
+		for (int view = 0; view < cameras.size(); view++) {
+			sums.col(clusters[view]) += centers.col(view);
+			cnts[clusters[view]]++;
+		}
+		for (int cluster = 0; cluster < k; cluster++)
+			if (cnts[cluster] > 0)
+				means.col(cluster) = sums.col(cluster) / float(cnts[cluster]);
+	}
+
+	// renumber by first view, dropping clusters left empty
+	std::vector<int> labels(k, -1);
+	int labelSize = 0;
+	for (int& cluster : clusters) {
+		if (labels[cluster] == -1)
+			labels[cluster] = labelSize++;
+		cluster = labels[cluster];
+	}
+	return clusters;
+}
+
+
 void SerializeCameras(const std::map<std::string, Camera>& cameras, const std::string& jsonFile)
 {
 	Json::Value json;
@@ -43,6 +43,16 @@ struct Camera
 std::map<std::string, Camera> ParseCameras(const std::string& jsonFile);
 void SerializeCameras(const std::map<std::string, Camera>& cameras, const std::string& jsonFile);
 
+// overlap(a, b): part of the working volume seen by camera a that camera b sees too, sampled on a grid of
+// sampleSize^3 points in the box
+Eigen::MatrixXf CalcViewOverlap(const std::map<std::string, Camera>& cameras, const Eigen::Vector3f& volumeMin,
+	const Eigen::Vector3f& volumeMax, const int& sampleSize = 16);
+
+// clusters[view]: cameras grouped into at most clusterSize clusters by the centroid of the part of the working volume
+// they see, so a cluster looks at one area. clusters are numbered by their first view
+std::vector<int> ClusterCameras(const std::map<std::string, Camera>& cameras, const Eigen::Vector3f& volumeMin,
+	const Eigen::Vector3f& volumeMax, const int& clusterSize, const int& sampleSize = 16);
+
 
 struct Triangulator
 {
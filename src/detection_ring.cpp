@@ -0,0 +1,181 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+#include "detection_ring.h"
+
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring counters must be lock-free to be shared between processes");
+
+
+namespace
+{
+	struct ViewEntry
+	{
+		uint32_t state;
+		uint32_t bytes;
+	};
+
+	char* GetSlot(DetectionRingHeader* header, const uint64_t& idx, const uint32_t& slotSize, const uint32_t& slotBytes)
+	{
+		return reinterpret_cast<char*>(header) + sizeof(DetectionRingHeader) + (idx % slotSize) * size_t(slotBytes);
+	}
+}
+
+
+bool DetectionRingWriter::Create(const std::string& name, const SkelType& type, const int& viewSize, const int& slotSize, const size_t& slotBytes)
+{
+	Close();
+	const size_t alignedSlotBytes = (slotBytes + 63) / 64 * 64;
+	if (viewSize <= 0 || slotSize <= 0 || alignedSlotBytes > UINT32_MAX
+		|| !m_memory.Create(name, sizeof(DetectionRingHeader) + slotSize * alignedSlotBytes))
+		return false;
+
+	m_header = new (m_memory.GetData()) DetectionRingHeader();
+	m_header->version = DETECTION_RING_VERSION;
+	m_header->skelType = int32_t(type);
+	m_header->viewSize = viewSize;
+	m_header->slotSize = uint32_t(slotSize);
+	m_header->slotBytes = uint32_t(alignedSlotBytes);
+	m_header->head.store(0, std::memory_order_relaxed);
+	m_header->tail.store(0, std::memory_order_relaxed);
+	m_header->closed.store(0, std::memory_order_relaxed);
+
+	// readers only accept the ring once the magic is visible
+	std::atomic_thread_fence(std::memory_order_release);
+	std::memcpy(m_header->magic, "4DRB", sizeof(m_header->magic));
+	m_frameIdx = 0;
+	m_dropCnt = 0;
+	return true;
+}
+
+
+void DetectionRingWriter::Close()
+{
+	if (m_header != nullptr)
+		m_header->closed.store(1, std::memory_order_release);
+	m_memory.Close();
+	m_header = nullptr;
+}
+
+
+bool DetectionRingWriter::Write(const std::vector<OpenposeDetection>& detections, const double& timestamp)
+{
+	assert(m_header != nullptr && detections.size() == m_header->viewSize);
+	const int64_t frameIdx = m_frameIdx++;
+	if (IsFull()) {
+		m_dropCnt++;
+		return false;
+	}
+
+	size_t bytes = sizeof(DetectionRingSlot) + detections.size() * sizeof(ViewEntry);
+	for (const auto& detection : detections)
+		bytes += GetDetectionFrameBytes(detection);
+	if (bytes > m_header->slotBytes) {
+		std::cerr << "detection frame exceeds ring slot: " << bytes << " > " << m_header->slotBytes << std::endl;
+		m_dropCnt++;
+		return false;
+	}
+
+	char* slot = GetSlot(m_header, m_header->head.load(std::memory_order_relaxed), m_header->slotSize, m_header->slotBytes);
+	DetectionRingSlot* info = reinterpret_cast<DetectionRingSlot*>(slot);
+	info->timestamp = timestamp;
+	info->frameIdx = frameIdx;
+	ViewEntry* entries = reinterpret_cast<ViewEntry*>(slot + sizeof(DetectionRingSlot));
+	char* data = slot + sizeof(DetectionRingSlot) + detections.size() * sizeof(ViewEntry);
+	for (int view = 0; view < detections.size(); view++) {
+		assert(detections[view].type == SkelType(m_header->skelType));
+		entries[view].state = detections[view].state;
+		entries[view].bytes = uint32_t(GetDetectionFrameBytes(detections[view]));
+		WriteDetectionFrame(detections[view], data);
+		data += entries[view].bytes;
+	}
+	m_header->head.store(m_header->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	return true;
+}
+
+
+bool DetectionRingReader::Open(const std::string& name)
+{
+	Close();
+	if (!m_memory.Open(name) || m_memory.GetSize() < sizeof(DetectionRingHeader))
+		return false;
+
+	// the header belongs to another process, its layout is validated once and kept here, so a producer changing it
+	// later can not move the reads out of the mapping
+	m_header = reinterpret_cast<DetectionRingHeader*>(m_memory.GetData());
+	const bool valid = std::memcmp(m_header->magic, "4DRB", sizeof(m_header->magic)) == 0;
+	std::atomic_thread_fence(std::memory_order_acquire);
+	m_type = SkelType(m_header->skelType);
+	m_viewSize = m_header->viewSize;
+	m_slotSize = m_header->slotSize;
+	m_slotBytes = m_header->slotBytes;
+	if (!valid || m_header->version != DETECTION_RING_VERSION || m_type < 0 || m_type >= SKEL_TYPE_SIZE
+		|| m_viewSize <= 0 || m_slotSize == 0
+		|| m_slotBytes < sizeof(DetectionRingSlot) + uint64_t(m_viewSize) * sizeof(ViewEntry)
+		|| m_memory.GetSize() < sizeof(DetectionRingHeader) + uint64_t(m_slotSize) * m_slotBytes) {
+		Close();
+		return false;
+	}
+	m_viewBytes.resize(m_viewSize);
+	m_frameIdx = -1;
+	m_dropCnt = 0;
+	return true;
+}
+
+
+bool DetectionRingReader::TryRead(std::vector<OpenposeDetection>& detections, double& timestamp)
+{
+	assert(m_header != nullptr);
+	// a corrupted frame is dropped and the next one read, a bad slot of the producer does not stop the tracker
+	for (uint64_t tail = m_header->tail.load(std::memory_order_relaxed); m_header->head.load(std::memory_order_acquire) != tail;
+		m_header->tail.store(++tail, std::memory_order_release)) {
+		const char* slot = GetSlot(m_header, tail, m_slotSize, m_slotBytes);
+		const DetectionRingSlot* info = reinterpret_cast<const DetectionRingSlot*>(slot);
+		const ViewEntry* entries = reinterpret_cast<const ViewEntry*>(slot + sizeof(DetectionRingSlot));
+		const char* data = slot + sizeof(DetectionRingSlot) + m_viewSize * sizeof(ViewEntry);
+
+		// the sizes are read once, the views have to fit into the slot as they are walked
+		uint64_t bytes = sizeof(DetectionRingSlot) + uint64_t(m_viewSize) * sizeof(ViewEntry);
+		for (int view = 0; view < m_viewSize; view++) {
+			m_viewBytes[view] = entries[view].bytes;
+			bytes += m_viewBytes[view];
+		}
+		bool valid = bytes <= m_slotBytes;
+		detections.resize(m_viewSize);
+		for (int view = 0; view < m_viewSize && valid; view++) {
+			valid = ReadDetectionFrame(data, m_viewBytes[view], m_type, detections[view]);
+			detections[view].state = entries[view].state;
+			data += m_viewBytes[view];
+		}
+		if (!valid) {
+			std::cerr << "dropped corrupted ring frame: " << info->frameIdx << std::endl;
+			m_dropCnt++;
+			continue;
+		}
+
+		timestamp = info->timestamp;
+		m_frameIdx = info->frameIdx;
+		m_header->tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+	return false;
+}
+
+
+bool DetectionRingReader::Read(std::vector<OpenposeDetection>& detections, double& timestamp)
+{
+	const auto start = std::chrono::steady_clock::now();
+	while (!TryRead(detections, timestamp)) {
+		// a frame may have landed between the failed read and the close flag
+		if (m_header->closed.load(std::memory_order_acquire))
+			return TryRead(detections, timestamp);
+		if (std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count() > m_timeout) {
+			std::cerr << "detection ring timed out after frame: " << m_frameIdx << std::endl;
+			return false;
+		}
+		std::this_thread::yield();
+	}
+	return true;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "openpose.h"
+#include "shared_memory.h"
+
+
+// lock-free single producer / single consumer ring of multi-view detection frames in shared memory.
+// a slot holds the frame timestamp and index, a {state, bytes} pair per view and then every view in the
+// binary detection frame layout. a full ring drops new frames instead of blocking the detector.
+struct DetectionRingHeader
+{
+	char magic[4];
+	uint32_t version;
+	int32_t skelType;
+	int32_t viewSize;
+	uint32_t slotSize;
+	uint32_t slotBytes;
+	alignas(64) std::atomic<uint64_t> head;		// frames written, only advanced by the producer
+	alignas(64) std::atomic<uint64_t> tail;		// frames read, only advanced by the consumer
+	alignas(64) std::atomic<uint32_t> closed;
+};
+
+
+struct DetectionRingSlot
+{
+	double timestamp;
+	int64_t frameIdx;
+};
+
+const uint32_t DETECTION_RING_VERSION = 1;
+
+
+class DetectionRingWriter
+{
+public:
+	DetectionRingWriter() {}
+	~DetectionRingWriter() { Close(); }
+	DetectionRingWriter(const DetectionRingWriter&) = delete;
+	DetectionRingWriter& operator=(const DetectionRingWriter&) = delete;
+
+	bool Create(const std::string& name, const SkelType& type, const int& viewSize, const int& slotSize = 8, const size_t& slotBytes = 4 << 20);
+	void Close();
+	bool Write(const std::vector<OpenposeDetection>& detections, const double& timestamp);
+	bool IsFull() const { return m_header->head.load(std::memory_order_relaxed) - m_header->tail.load(std::memory_order_acquire) >= m_header->slotSize; }
+	int64_t GetDropCnt() const { return m_dropCnt; }
+
+private:
+	SharedMemory m_memory;
+	DetectionRingHeader* m_header = nullptr;
+	int64_t m_frameIdx = 0;
+	int64_t m_dropCnt = 0;
+};
+
+
+class DetectionRingReader
+{
+public:
+	DetectionRingReader() {}
+	DetectionRingReader(const DetectionRingReader&) = delete;
+	DetectionRingReader& operator=(const DetectionRingReader&) = delete;
+
+	bool Open(const std::string& name);
+	void Close() { m_memory.Close(); m_header = nullptr; }
+	SkelType GetType() const { return m_type; }
+	int GetViewSize() const { return m_viewSize; }
+	int64_t GetFrameIdx() const { return m_frameIdx; }
+	int64_t GetDropCnt() const { return m_dropCnt; }		// corrupted frames skipped by the reader
+
+	// decode the oldest frame straight from its slot into the existing buffers of detections,
+	// Read waits for the producer and returns false once it closed the ring and every frame was read,
+	// or when no frame arrived for the timeout in seconds, as with a producer that died without closing
+	// the ring is written by another process, a corrupted frame is dropped and counted instead of read
+	bool TryRead(std::vector<OpenposeDetection>& detections, double& timestamp);
+	bool Read(std::vector<OpenposeDetection>& detections, double& timestamp);
+	void SetTimeout(const float& _timeout) { m_timeout = _timeout; }
+
+private:
+	SharedMemory m_memory;
+	DetectionRingHeader* m_header = nullptr;
+	SkelType m_type = SKEL_TYPE_NONE;
+	int m_viewSize = 0;
+	uint32_t m_slotSize = 0;
+	uint32_t m_slotBytes = 0;
+	std::vector<uint32_t> m_viewBytes;			// m_viewBytes[view], sizes of the frame being read
+	int64_t m_frameIdx = -1;
+	int64_t m_dropCnt = 0;
+	float m_timeout = 10.f;
+};
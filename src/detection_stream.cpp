@@ -0,0 +1,128 @@
+#include <iostream>
+#include <climits>
+#include "detection_stream.h"
+
+
+TextDetectionSource::TextDetectionSource(const std::string& filename)
+{
+	// an invalid file yields no frames, which stops the stream. the frames are parsed from the mapping one by one
+	// as the stream's prefetch thread reads them
+	if (!m_file.Open(filename)) {
+		std::cerr << "file not exist: " << filename << std::endl;
+		return;
+	}
+
+	m_parser = TextParser(m_file.GetData(), m_file.GetData() + m_file.GetSize());
+	const int skelType = m_parser.Parse<int>();
+	const int frameSize = m_parser.Parse<int>();
+	if (m_parser.Fail() || skelType < 0 || skelType >= SKEL_TYPE_SIZE || frameSize < 0) {
+		std::cerr << "invalid detection file: " << filename << std::endl;
+		return;
+	}
+	m_type = SkelType(skelType);
+	m_frameSize = frameSize;
+}
+
+
+bool TextDetectionSource::Read(OpenposeDetection& detection)
+{
+	if (m_frameIdx >= m_frameSize)
+		return false;
+	if (!ParseDetection(m_parser, m_type, detection)) {
+		std::cerr << "invalid or truncated detection file at frame " << m_frameIdx << std::endl;
+		m_frameSize = m_frameIdx;
+		return false;
+	}
+	m_frameIdx++;
+	return true;
+}
+
+
+bool BinaryDetectionSource::Read(OpenposeDetection& detection)
+{
+	if (m_frameIdx >= m_frameSize)
+		return false;
+	if (!m_file.ReadDetection(m_frameIdx, detection)) {
+		m_frameSize = m_frameIdx;
+		return false;
+	}
+	m_frameIdx++;
+	return true;
+}
+
+
+std::unique_ptr<DetectionSource> OpenDetectionSource(const std::string& filename)
+{
+	if (IsDetectionFile(filename))
+		return std::make_unique<BinaryDetectionSource>(filename);
+	else
+		return std::make_unique<TextDetectionSource>(filename);
+}
+
+
+DetectionStream::DetectionStream(const std::vector<std::string>& filenames, const DetectionPreprocess& preprocess, const int& readAhead)
+{
+	m_readAhead = std::max(readAhead, 1);
+	m_preprocess = preprocess;
+	assert(m_preprocess.imgSizes.empty() || m_preprocess.imgSizes.size() == filenames.size());
+	m_sources.resize(filenames.size());
+#pragma omp parallel for
+	for (int view = 0; view < filenames.size(); view++)
+		m_sources[view] = OpenDetectionSource(filenames[view]);
+
+	m_frameSize = m_sources.empty() ? 0 : INT_MAX;
+	for (const auto& source : m_sources)
+		m_frameSize = std::min(m_frameSize, source->GetFrameSize());
+
+	m_thread = std::thread(&DetectionStream::Prefetch, this);
+}
+
+
+DetectionStream::~DetectionStream()
+{
+	{
+		std::unique_lock<std::mutex> locker(m_mutex);
+		m_stop = true;
+	}
+	m_writeCond.notify_all();
+	if (m_thread.joinable())
+		m_thread.join();
+}
+
+
+void DetectionStream::Prefetch()
+{
+	for (int frameIdx = 0; frameIdx < m_frameSize && !m_stop; frameIdx++) {
+		std::vector<OpenposeDetection> detections(m_sources.size());
+		bool valid = true;
+		for (int view = 0; view < m_sources.size() && valid; view++)
+			valid = m_sources[view]->Read(detections[view]);
+		if (!valid)
+			break;
+		for (int view = 0; view < m_sources.size(); view++)
+			m_preprocess.Apply(view, detections[view]);
+
+		std::unique_lock<std::mutex> locker(m_mutex);
+		m_writeCond.wait(locker, [&] { return m_frames.size() < m_readAhead || m_stop; });
+		m_frames.emplace_back(std::move(detections));
+		m_readCond.notify_one();
+	}
+
+	std::unique_lock<std::mutex> locker(m_mutex);
+	m_finished = true;
+	m_readCond.notify_one();
+}
+
+
+bool DetectionStream::Read(std::vector<OpenposeDetection>& detections)
+{
+	std::unique_lock<std::mutex> locker(m_mutex);
+	m_readCond.wait(locker, [&] { return !m_frames.empty() || m_finished; });
+	if (m_frames.empty())
+		return false;
+
+	detections = std::move(m_frames.front());
+	m_frames.pop_front();
+	m_writeCond.notify_one();
+	return true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include "openpose.h"
+#include "text_parser.h"
+
+
+// sequential reader of a single view's detections, a missing or invalid file has no frames
+class DetectionSource
+{
+public:
+	virtual ~DetectionSource() = default;
+	virtual int GetFrameSize() const = 0;
+	virtual bool Read(OpenposeDetection& detection) = 0;
+};
+
+
+class TextDetectionSource : public DetectionSource
+{
+public:
+	TextDetectionSource(const std::string& filename);
+	virtual int GetFrameSize() const override { return m_frameSize; }
+	virtual bool Read(OpenposeDetection& detection) override;
+
+private:
+	MappedFile m_file;
+	TextParser m_parser{ nullptr, nullptr };
+	SkelType m_type = SKEL_TYPE_NONE;
+	int m_frameSize = 0;
+	int m_frameIdx = 0;
+};
+
+
+class BinaryDetectionSource : public DetectionSource
+{
+public:
+	BinaryDetectionSource(const std::string& filename) { if (m_file.Open(filename)) m_frameSize = m_file.GetFrameSize(); }
+	virtual int GetFrameSize() const override { return m_frameSize; }
+	virtual bool Read(OpenposeDetection& detection) override;
+
+private:
+	DetectionFile m_file;
+	int m_frameSize = 0;
+	int m_frameIdx = 0;
+};
+
+
+std::unique_ptr<DetectionSource> OpenDetectionSource(const std::string& filename);
+
+
+// yields one synchronized multi-view frame at a time, a background thread reads and preprocesses at most readAhead frames in advance
+class DetectionStream
+{
+public:
+	DetectionStream(const std::vector<std::string>& filenames, const DetectionPreprocess& preprocess = DetectionPreprocess(), const int& readAhead = 4);
+	~DetectionStream();
+	DetectionStream(const DetectionStream&) = delete;
+	DetectionStream& operator=(const DetectionStream&) = delete;
+
+	int GetViewSize() const { return int(m_sources.size()); }
+	int GetFrameSize() const { return m_frameSize; }
+	bool Read(std::vector<OpenposeDetection>& detections);
+
+private:
+	std::vector<std::unique_ptr<DetectionSource>> m_sources;
+	int m_frameSize;
+	int m_readAhead;
+	DetectionPreprocess m_preprocess;
+
+	std::deque<std::vector<OpenposeDetection>> m_frames;
+	bool m_finished = false;
+	std::atomic<bool> m_stop{ false };
+	std::mutex m_mutex;
+	std::condition_variable m_readCond, m_writeCond;
+	std::thread m_thread;
+
+	void Prefetch();
+};
@@ -0,0 +1,91 @@
+#include <algorithm>
+#include "edge_graph.h"
+
+
+float EdgeGraph::View::operator()(const int& row, const int& col) const
+{
+	const std::vector<int>& neighbors = m_transposed ? m_graph->m_colRows : m_graph->m_rowCols;
+	const auto begin = neighbors.begin() + GetBegin(row);
+	const auto end = neighbors.begin() + GetEnd(row);
+	const auto iter = std::lower_bound(begin, end, col);
+	return iter != end && *iter == col ? GetWeight(int(iter - neighbors.begin())) : -1.f;
+}
+
+
+void EdgeGraph::Clear(const int& rows, const int& cols)
+{
+	m_rowSize = rows;
+	m_colSize = cols;
+	m_rowStart.assign(rows + 1, 0);
+	m_colStart.assign(cols + 1, 0);
+	m_rowCols.clear();
+	m_colRows.clear();
+	m_colEdges.clear();
+	m_weights.clear();
+}
+
+
+void EdgeGraph::Build(const int& rows, const int& cols, const std::vector<Edge>& edges)
+{
+	m_rowSize = rows;
+	m_colSize = cols;
+	const int edgeSize = int(edges.size());
+
+	// counting sort by column, then a stable one by row, so every row ends up sorted by column
+	m_colStart.assign(cols + 1, 0);
+	for (const Edge& edge : edges)
+		m_colStart[edge.col + 1]++;
+	for (int col = 0; col < cols; col++)
+		m_colStart[col + 1] += m_colStart[col];
+	m_cursor.assign(m_colStart.begin(), m_colStart.end() - 1);
+	m_buffer.resize(edgeSize);
+	for (const Edge& edge : edges)
+		m_buffer[m_cursor[edge.col]++] = edge;
+
+	m_rowStart.assign(rows + 1, 0);
+	for (const Edge& edge : m_buffer)
+		m_rowStart[edge.row + 1]++;
+	for (int row = 0; row < rows; row++)
+		m_rowStart[row + 1] += m_rowStart[row];
+	m_cursor.assign(m_rowStart.begin(), m_rowStart.end() - 1);
+	m_rowCols.resize(edgeSize);
+	m_weights.resize(edgeSize);
+	for (const Edge& edge : m_buffer) {
+		const int i = m_cursor[edge.row]++;
+		m_rowCols[i] = edge.col;
+		m_weights[i] = edge.weight;
+	}
+
+	// column index, walking the rows in order keeps every column sorted by row
+	m_cursor.assign(m_colStart.begin(), m_colStart.end() - 1);
+	m_colRows.resize(edgeSize);
+	m_colEdges.resize(edgeSize);
+	for (int row = 0; row < rows; row++) {
+		for (int i = m_rowStart[row]; i < m_rowStart[row + 1]; i++) {
+			const int j = m_cursor[m_rowCols[i]]++;
+			m_colRows[j] = row;
+			m_colEdges[j] = i;
+		}
+	}
+}
+
+
+void EdgeGraph::Normalize()
+{
+	m_rowSum.assign(m_rowSize, 0.f);
+	m_colSum.assign(m_colSize, 0.f);
+	for (int row = 0; row < m_rowSize; row++) {
+		for (int i = m_rowStart[row]; i < m_rowStart[row + 1]; i++) {
+			m_rowSum[row] += m_weights[i];
+			m_colSum[m_rowCols[i]] += m_weights[i];
+		}
+	}
+	for (int row = 0; row < m_rowSize; row++)
+		m_rowSum[row] = std::max(m_rowSum[row] - float(m_colSize - (m_rowStart[row + 1] - m_rowStart[row])), 1.f);
+	for (int col = 0; col < m_colSize; col++)
+		m_colSum[col] = std::max(m_colSum[col] - float(m_rowSize - (m_colStart[col + 1] - m_colStart[col])), 1.f);
+
+	for (int row = 0; row < m_rowSize; row++)
+		for (int i = m_rowStart[row]; i < m_rowStart[row + 1]; i++)
+			m_weights[i] = m_weights[i] / m_rowSum[row] / m_colSum[m_rowCols[i]];
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+
+
+// sparse weighted edges between two candidate sets, e.g. the joint candidates of two views, reading -1 for missing
+// edges like the dense edge matrices did. edges are stored once in compressed rows sorted by column, with a
+// compressed column index into them, so the transpose is a view instead of a copy.
+class EdgeGraph
+{
+public:
+	struct Edge
+	{
+		int row, col;
+		float weight;
+	};
+
+	// the graph seen from its rows or, transposed, from its columns
+	class View
+	{
+	public:
+		View(const EdgeGraph& graph, const bool& transposed) { m_graph = &graph; m_transposed = transposed; }
+		int GetRows() const { return m_transposed ? m_graph->m_colSize : m_graph->m_rowSize; }
+		int GetCols() const { return m_transposed ? m_graph->m_rowSize : m_graph->m_colSize; }
+		int GetBegin(const int& row) const { return (m_transposed ? m_graph->m_colStart : m_graph->m_rowStart)[row]; }
+		int GetEnd(const int& row) const { return (m_transposed ? m_graph->m_colStart : m_graph->m_rowStart)[row + 1]; }
+		int GetNeighbor(const int& i) const { return m_transposed ? m_graph->m_colRows[i] : m_graph->m_rowCols[i]; }
+		float GetWeight(const int& i) const { return m_graph->m_weights[m_transposed ? m_graph->m_colEdges[i] : i]; }
+		float operator()(const int& row, const int& col) const;
+
+	private:
+		const EdgeGraph* m_graph;
+		bool m_transposed;
+	};
+
+	int GetRows() const { return m_rowSize; }
+	int GetCols() const { return m_colSize; }
+	int GetEdgeSize() const { return int(m_weights.size()); }
+	View Rows() const { return View(*this, false); }
+	View Cols() const { return View(*this, true); }
+	float operator()(const int& row, const int& col) const { return Rows()(row, col); }
+
+	void Clear(const int& rows, const int& cols);
+	void Build(const int& rows, const int& cols, const std::vector<Edge>& edges);
+
+	// divides every edge by its row and column sums (at least 1), counting the missing edges as -1
+	void Normalize();
+
+private:
+	int m_rowSize = 0, m_colSize = 0;
+	std::vector<int> m_rowStart, m_rowCols;
+	std::vector<int> m_colStart, m_colRows, m_colEdges;		// m_colEdges: index of the edge in the row storage
+	std::vector<float> m_weights;
+	std::vector<Edge> m_buffer;
+	std::vector<int> m_cursor;
+	std::vector<float> m_rowSum, m_colSum;
+};
@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <cfloat>
+#include <Eigen/Eigen>
+#include "epi_kernel.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+
+namespace
+{
+	const int BAND_BIN_SIZE = 32;
+	const int BAND_MIN_CANDI = 32;			// below this many candidates in view B the dense kernel is cheaper
+	const float BAND_MIN_SIN = 0.25f;		// rays of view B closer than this to the baseline direction are tested against all of A
+	const float BAND_MAX_NEAR = 0.25f;		// above this fraction of such rays, e.g. for facing cameras, the dense kernel is cheaper
+
+	// rays of view A, their cross product w with the baseline (posA - posB) and |w|, the point to line distance
+	struct RaySoA
+	{
+		std::vector<float> x, y, z, wx, wy, wz, pointDist;
+	};
+
+
+	// view B candidates sorted by epipolar plane angle, with their projection (u, v) on the plane perpendicular to
+	// the baseline and the smallest |(u, v)| of every bin
+	struct BandBins
+	{
+		std::vector<int> bin, start, fill, items;
+		std::vector<float> u, v, minSin;
+	};
+
+
+	inline float CalcEpi(const RaySoA& soa, const int& a, const float& bx, const float& by, const float& bz, const float& maxDist)
+	{
+		const float ax = soa.x[a], ay = soa.y[a], az = soa.z[a];
+		float dist;
+		if (std::abs(ax * bx + ay * by + az * bz) < 1e-5f)
+			dist = soa.pointDist[a];
+		else {
+			const float cx = ay * bz - az * by;
+			const float cy = az * bx - ax * bz;
+			const float cz = ax * by - ay * bx;
+			const float den2 = cx * cx + cy * cy + cz * cz;
+			// (posA - posB) . (a x b) == b . ((posA - posB) x a)
+			dist = den2 > 0.f ? std::abs(bx * soa.wx[a] + by * soa.wy[a] + bz * soa.wz[a]) / std::sqrt(den2) : 0.f;
+		}
+		return dist < maxDist ? 1.f - dist / maxDist : -1.f;
+	}
+
+
+	void Fill(RaySoA& soa, const Eigen::Vector3f& posA, const Eigen::Ref<const Eigen::Matrix3Xf>& raysA, const Eigen::Vector3f& posB)
+	{
+		const int sizeA = int(raysA.cols());
+		for (auto* arr : { &soa.x, &soa.y, &soa.z, &soa.wx, &soa.wy, &soa.wz, &soa.pointDist })
+			arr->resize(sizeA);
+
+		const Eigen::Vector3f baseline = posA - posB;
+		for (int a = 0; a < sizeA; a++) {
+			const Eigen::Vector3f w = baseline.cross(raysA.col(a));
+			soa.x[a] = raysA(0, a);
+			soa.y[a] = raysA(1, a);
+			soa.z[a] = raysA(2, a);
+			soa.wx[a] = w.x();
+			soa.wy[a] = w.y();
+			soa.wz[a] = w.z();
+			soa.pointDist[a] = w.norm();
+		}
+	}
+
+
+	void Calc(const Eigen::Vector3f& posA, const Eigen::Ref<const Eigen::Matrix3Xf>& raysA, const Eigen::Vector3f& posB,
+		const Eigen::Ref<const Eigen::Matrix3Xf>& raysB, const float& maxDist, const bool& normalize, EdgeGraph& epi, const bool& simd)
+	{
+		const int sizeA = int(raysA.cols());
+		const int sizeB = int(raysB.cols());
+		thread_local RaySoA threadSoa;
+		RaySoA& soa = threadSoa;
+		Fill(soa, posA, raysA, posB);
+		thread_local std::vector<EdgeGraph::Edge> threadEdges;
+		std::vector<EdgeGraph::Edge>& edges = threadEdges;
+		edges.clear();
+
+		for (int b = 0; b < sizeB; b++) {
+			const float bx = raysB(0, b), by = raysB(1, b), bz = raysB(2, b);
+			int a = 0;
+#ifdef __AVX2__
+			if (simd) {
+				const __m256 vbx = _mm256_set1_ps(bx), vby = _mm256_set1_ps(by), vbz = _mm256_set1_ps(bz);
+				const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+				const __m256 eps = _mm256_set1_ps(1e-5f), zero = _mm256_setzero_ps();
+				const __m256 one = _mm256_set1_ps(1.f), vMaxDist = _mm256_set1_ps(maxDist);
+				for (; a + 8 <= sizeA; a += 8) {
+					const __m256 ax = _mm256_loadu_ps(&soa.x[a]), ay = _mm256_loadu_ps(&soa.y[a]), az = _mm256_loadu_ps(&soa.z[a]);
+					const __m256 dot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, vbx), _mm256_mul_ps(ay, vby)), _mm256_mul_ps(az, vbz));
+					const __m256 cx = _mm256_sub_ps(_mm256_mul_ps(ay, vbz), _mm256_mul_ps(az, vby));
+					const __m256 cy = _mm256_sub_ps(_mm256_mul_ps(az, vbx), _mm256_mul_ps(ax, vbz));
+					const __m256 cz = _mm256_sub_ps(_mm256_mul_ps(ax, vby), _mm256_mul_ps(ay, vbx));
+					const __m256 den2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, cx), _mm256_mul_ps(cy, cy)), _mm256_mul_ps(cz, cz));
+					const __m256 num = _mm256_and_ps(absMask, _mm256_add_ps(_mm256_add_ps(
+						_mm256_mul_ps(vbx, _mm256_loadu_ps(&soa.wx[a])), _mm256_mul_ps(vby, _mm256_loadu_ps(&soa.wy[a]))),
+						_mm256_mul_ps(vbz, _mm256_loadu_ps(&soa.wz[a]))));
+
+					// zero length cross products give 0 / 0, masked to a distance of 0
+					const __m256 lineDist = _mm256_and_ps(_mm256_div_ps(num, _mm256_sqrt_ps(den2)), _mm256_cmp_ps(den2, zero, _CMP_GT_OQ));
+					const __m256 dist = _mm256_blendv_ps(lineDist, _mm256_loadu_ps(&soa.pointDist[a]),
+						_mm256_cmp_ps(_mm256_and_ps(absMask, dot), eps, _CMP_LT_OQ));
+					const int inside = _mm256_movemask_ps(_mm256_cmp_ps(dist, vMaxDist, _CMP_LT_OQ));
+					if (inside == 0)
+						continue;
+
+					alignas(32) float lanes[8];
+					_mm256_store_ps(lanes, _mm256_sub_ps(one, _mm256_div_ps(dist, vMaxDist)));
+					for (int lane = 0; lane < 8; lane++)
+						if (inside & (1 << lane))
+							edges.emplace_back(EdgeGraph::Edge{ a + lane, b, lanes[lane] });
+				}
+			}
+#endif
+			for (; a < sizeA; a++) {
+				const float e = CalcEpi(soa, a, bx, by, bz, maxDist);
+				if (e > -1.f)
+					edges.emplace_back(EdgeGraph::Edge{ a, b, e });
+			}
+		}
+
+		epi.Build(sizeA, sizeB, edges);
+		if (normalize)
+			epi.Normalize();
+	}
+}
+
+
+namespace EpiKernel
+{
+	void CalcEpiEdge(const Eigen::Vector3f& posA, const Eigen::Ref<const Eigen::Matrix3Xf>& raysA, const Eigen::Vector3f& posB,
+		const Eigen::Ref<const Eigen::Matrix3Xf>& raysB, const float& maxDist, const bool& normalize, EdgeGraph& epi)
+	{
+		Calc(posA, raysA, posB, raysB, maxDist, normalize, epi, true);
+	}
+
+
+	void CalcEpiEdgeScalar(const Eigen::Vector3f& posA, const Eigen::Ref<const Eigen::Matrix3Xf>& raysA, const Eigen::Vector3f& posB,
+		const Eigen::Ref<const Eigen::Matrix3Xf>& raysB, const float& maxDist, const bool& normalize, EdgeGraph& epi)
+	{
+		Calc(posA, raysA, posB, raysB, maxDist, normalize, epi, false);
+	}
+}
+
+
+EpiBandIndex::EpiBandIndex(const Eigen::Vector3f& posA, const Eigen::Vector3f& posB)
+{
+	m_posA = posA;
+	m_posB = posB;
+	m_baseline = (posA - posB).norm();
+	const Eigen::Vector3f axis = (posA - posB).normalized();
+	m_axisU = axis.unitOrthogonal();
+	m_axisV = axis.cross(m_axisU);
+}
+
+
+void EpiBandIndex::CalcEpiEdge(const Eigen::Ref<const Eigen::Matrix3Xf>& raysA, const Eigen::Ref<const Eigen::Matrix3Xf>& raysB,
+	const float& maxDist, const bool& normalize, EdgeGraph& epi) const
+{
+	const int sizeA = int(raysA.cols());
+	const int sizeB = int(raysB.cols());
+	if (sizeB < BAND_MIN_CANDI || m_baseline < FLT_EPSILON) {
+		EpiKernel::CalcEpiEdge(m_posA, raysA, m_posB, raysB, maxDist, normalize, epi);
+		return;
+	}
+
+	// a ray projected on the plane perpendicular to the baseline is p = sin(ray, baseline) * (cos(t), sin(t)) with t
+	// the plane angle, and the line to line distance of two rays is at least baseline * |pA x pB|. rays pointing to
+	// -p lie in the same plane, so everything is folded into t in [0, pi). bins are uniform in the pseudo angle
+	// q = v / (|u| + |v|) style in [0, 2), which is monotonic in t and avoids atan2.
+	auto PseudoAngle = [](float u, float v) {
+		if (v < 0.f || (v == 0.f && u < 0.f)) {
+			u = -u;
+			v = -v;
+		}
+		const float sum = std::abs(u) + v;
+		if (sum <= 0.f)
+			return 0.f;
+		return u >= 0.f ? v / sum : 1.f - u / sum;
+	};
+	auto PlaneBin = [&PseudoAngle](const float& u, const float& v) {
+		return std::min(int(PseudoAngle(u, v) * (BAND_BIN_SIZE / 2)), BAND_BIN_SIZE - 1);
+	};
+	static const std::vector<Eigen::Vector2f> binEdges = [] {
+		std::vector<Eigen::Vector2f> edges(BAND_BIN_SIZE + 1);
+		for (int bin = 0; bin <= BAND_BIN_SIZE; bin++) {
+			const float q = 2.f * bin / BAND_BIN_SIZE;
+			edges[bin] = (q <= 1.f ? Eigen::Vector2f(1.f - q, q) : Eigen::Vector2f(1.f - q, 2.f - q)).normalized();
+		}
+		return edges;
+	}();
+	const float reach = maxDist * 1.001f / m_baseline;
+
+	// counting sort of view B into angle bins, plus a last bin of rays near the baseline direction: their p is short
+	// so they can be close to rays in any plane
+	thread_local BandBins threadBins;
+	BandBins& bins = threadBins;
+	bins.bin.resize(sizeB);
+	bins.items.resize(sizeB);
+	bins.u.resize(sizeB);
+	bins.v.resize(sizeB);
+	bins.start.assign(BAND_BIN_SIZE + 2, 0);
+	bins.minSin.assign(BAND_BIN_SIZE, 1.f);
+	float minSin = 1.f;
+	for (int b = 0; b < sizeB; b++) {
+		const float u = m_axisU.dot(raysB.col(b));
+		const float v = m_axisV.dot(raysB.col(b));
+		const float sine = std::sqrt(u * u + v * v);
+		const int bin = sine < BAND_MIN_SIN ? BAND_BIN_SIZE : PlaneBin(u, v);
+		bins.bin[b] = bin;
+		bins.start[bin + 1]++;
+		if (bin < BAND_BIN_SIZE) {
+			bins.minSin[bin] = std::min(bins.minSin[bin], sine);
+			minSin = std::min(minSin, sine);
+		}
+	}
+	if (bins.start[BAND_BIN_SIZE + 1] > BAND_MAX_NEAR * sizeB) {
+		EpiKernel::CalcEpiEdge(m_posA, raysA, m_posB, raysB, maxDist, normalize, epi);
+		return;
+	}
+	for (int bin = 0; bin <= BAND_BIN_SIZE; bin++)
+		bins.start[bin + 1] += bins.start[bin];
+	bins.fill.assign(bins.start.begin(), bins.start.end() - 1);
+	for (int b = 0; b < sizeB; b++) {
+		const int i = bins.fill[bins.bin[b]]++;
+		bins.items[i] = b;
+		bins.u[i] = m_axisU.dot(raysB.col(b));
+		bins.v[i] = m_axisV.dot(raysB.col(b));
+	}
+
+	thread_local RaySoA threadSoa;
+	RaySoA& soa = threadSoa;
+	Fill(soa, m_posA, raysA, m_posB);
+	thread_local std::vector<EdgeGraph::Edge> threadEdges;
+	std::vector<EdgeGraph::Edge>& edges = threadEdges;
+	edges.clear();
+	auto Test = [&](const int& a, const int& b) {
+		const float e = CalcEpi(soa, a, raysB(0, b), raysB(1, b), raysB(2, b), maxDist);
+		if (e > -1.f)
+			edges.emplace_back(EdgeGraph::Edge{ a, b, e });
+	};
+
+	// |pA x e(t)| grows while t moves away from the plane angle of a ray of view A, up to pi / 2 on either side,
+	// so the bins within reach form a run around its own bin and the walk stops at the first bin out of reach
+	// of the shortest binned p
+	for (int a = 0; a < sizeA; a++) {
+		const float uA = m_axisU.dot(raysA.col(a));
+		const float vA = m_axisV.dot(raysA.col(a));
+		// the perpendicular case of CalcEpi falls back to the point distance, which the bound does not cover
+		const bool testAll = soa.pointDist[a] < maxDist;
+		auto TestBin = [&](const int& bin) {
+			for (int i = bins.start[bin]; i < bins.start[bin + 1]; i++)
+				if (testAll || std::abs(uA * bins.v[i] - vA * bins.u[i]) < reach)
+					Test(a, bins.items[i]);
+		};
+
+		TestBin(BAND_BIN_SIZE);
+		const int home = PlaneBin(uA, vA);
+		TestBin(home);
+		int visited = 1;
+		for (const int& dir : { 1, -1 }) {
+			int bin = home;
+			for (; visited < BAND_BIN_SIZE; visited++) {
+				bin += dir;
+				bin = bin < 0 ? BAND_BIN_SIZE - 1 : bin == BAND_BIN_SIZE ? 0 : bin;
+				const Eigen::Vector2f& nearEdge = binEdges[dir > 0 ? bin : bin + 1];
+				const Eigen::Vector2f& farEdge = binEdges[dir > 0 ? bin + 1 : bin];
+				const float nearCross = std::abs(uA * nearEdge.y() - vA * nearEdge.x());
+				if (!testAll && minSin * nearCross >= reach)
+					break;
+				const float farCross = std::abs(uA * farEdge.y() - vA * farEdge.x());
+				if (testAll || bins.minSin[bin] * std::min(nearCross, farCross) < reach)
+					TestBin(bin);
+			}
+		}
+	}
+
+	epi.Build(sizeA, sizeB, edges);
+	if (normalize)
+		epi.Normalize();
+}
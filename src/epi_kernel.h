@@ -0,0 +1,39 @@
+#pragma once
+#include <Eigen/Core>
+#include "edge_graph.h"
+
+
+// epipolar edges between the joint rays of two views with distance, threshold and normalization fused:
+// epi(a, b) = 1 - dist / maxDist for ray pairs closer than maxDist, missing otherwise, then normalized by
+// EdgeGraph::Normalize when normalize is set. dist follows Associater::Line2LineDist up to float rounding.
+// the rays of view A are laid out as structure of arrays and a column of epi is computed 8 candidates at a time,
+// with AVX2 when the compiler targets it and with plain loops otherwise.
+namespace EpiKernel
+{
+	void CalcEpiEdge(const Eigen::Vector3f& posA, const Eigen::Ref<const Eigen::Matrix3Xf>& raysA, const Eigen::Vector3f& posB,
+		const Eigen::Ref<const Eigen::Matrix3Xf>& raysB, const float& maxDist, const bool& normalize, EdgeGraph& epi);
+
+	// same without SIMD intrinsics
+	void CalcEpiEdgeScalar(const Eigen::Vector3f& posA, const Eigen::Ref<const Eigen::Matrix3Xf>& raysA, const Eigen::Vector3f& posB,
+		const Eigen::Ref<const Eigen::Matrix3Xf>& raysB, const float& maxDist, const bool& normalize, EdgeGraph& epi);
+}
+
+
+// per camera pair index over the epipolar planes, the planes through both camera centers. every ray lies in one
+// of them and two rays whose planes are t apart are at least baseline * sin(a, baseline) * sin(b, baseline) * sin(t)
+// apart, so the candidates of view B are binned by plane angle and a ray of view A is only tested against the bins
+// within reach of maxDist. gives the same edges as EpiKernel::CalcEpiEdge up to float rounding, and
+// falls back to it for few candidates or when many rays of B point along the baseline.
+class EpiBandIndex
+{
+public:
+	EpiBandIndex() = default;
+	EpiBandIndex(const Eigen::Vector3f& posA, const Eigen::Vector3f& posB);
+	void CalcEpiEdge(const Eigen::Ref<const Eigen::Matrix3Xf>& raysA, const Eigen::Ref<const Eigen::Matrix3Xf>& raysB,
+		const float& maxDist, const bool& normalize, EdgeGraph& epi) const;
+
+private:
+	Eigen::Vector3f m_posA, m_posB;
+	Eigen::Vector3f m_axisU, m_axisV;		// orthonormal basis of the plane perpendicular to the baseline
+	float m_baseline = 0.f;
+};
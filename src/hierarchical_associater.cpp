@@ -0,0 +1,241 @@
+#include <chrono>
+#include <algorithm>
+#include "hierarchical_associater.h"
+#include "hungarian_algorithm.h"
+
+
+HierarchicalAssociater::HierarchicalAssociater(const SkelType& type, const std::map<std::string, Camera>& cams, const std::vector<int>& clusters)
+	: Associater(type, cams)
+{
+	assert(clusters.size() == m_cams.size());
+	const int clusterSize = clusters.empty() ? 0 : *std::max_element(clusters.begin(), clusters.end()) + 1;
+	m_clusterViews.resize(clusterSize);
+	std::vector<std::map<std::string, Camera>> clusterCams(clusterSize);
+	int view = 0;
+	for (auto camIter = m_cams.begin(); camIter != m_cams.end(); camIter++, view++) {
+		m_clusterViews[clusters[view]].emplace_back(view);
+		clusterCams[clusters[view]].insert(*camIter);
+		m_camPositions.emplace_back(camIter->second.eiPos);
+	}
+
+	// a sub map keeps the order of the names, so the views of a cluster ascend as its own views do
+	for (int cluster = 0; cluster < clusterSize; cluster++)
+		m_clusters.emplace_back(new KruskalAssociater(type, clusterCams[cluster]));
+}
+
+
+void HierarchicalAssociater::TriangulatePartial(const int& cluster, const PersonStore::ConstPerson& partial, Eigen::Matrix4Xf& skel3d)
+{
+	// the point closest to the joint rays in closed form, kept if it lies near enough to them
+	const SkelDef& def = GetSkelDef(m_type);
+	const std::vector<int>& views = m_clusterViews[cluster];
+	skel3d.setZero(4, def.jointSize);
+	for (int jIdx = 0; jIdx < def.jointSize; jIdx++) {
+		Eigen::Matrix3f ATA = Eigen::Matrix3f::Zero();
+		Eigen::Vector3f ATb = Eigen::Vector3f::Zero();
+		int cnt = 0;
+		for (int i = 0; i < views.size(); i++) {
+			if (partial(jIdx, i) != -1) {
+				const Eigen::Vector3f ray = GetJointRays(views[i], jIdx).col(partial(jIdx, i));
+				const Eigen::Matrix3f A = Eigen::Matrix3f::Identity() - ray * ray.transpose();
+				ATA += A;
+				ATb += A * m_camPositions[views[i]];
+				cnt++;
+			}
+		}
+		if (cnt < 2)
+			continue;
+
+		const Eigen::Vector3f pos = ATA.ldlt().solve(ATb);
+		float dist = 0.f;
+		for (int i = 0; i < views.size(); i++)
+			if (partial(jIdx, i) != -1)
+				dist += Point2LineDist(pos, m_camPositions[views[i]], GetJointRays(views[i], jIdx).col(partial(jIdx, i)));
+		if (dist / float(cnt) < m_triangulateThresh)
+			skel3d.col(jIdx) = pos.homogeneous();
+	}
+}
+
+
+void HierarchicalAssociater::MergePartial(const int& cluster, const PersonStore::ConstPerson& partial, const Eigen::Matrix4Xf& skel3d, const int& pIdx)
+{
+	const SkelDef& def = GetSkelDef(m_type);
+	const std::vector<int>& views = m_clusterViews[cluster];
+	PersonStore::Person person = m_persons[pIdx];
+	for (int i = 0; i < views.size(); i++) {
+		for (int jIdx = 0; jIdx < def.jointSize; jIdx++) {
+			if (partial(jIdx, i) != -1) {
+				person(jIdx, views[i]) = partial(jIdx, i);
+				m_assignMap[views[i]][jIdx][partial(jIdx, i)] = pIdx;
+			}
+		}
+	}
+	m_skels3d[pIdx] += skel3d;
+}
+
+
+float HierarchicalAssociater::CalcMergeDist(const int& pIdx, const int& cluster, const PersonStore::ConstPerson& partial, const Eigen::Matrix4Xf& partialSkel3d)
+{
+	// triangulated joints of either side against the rays of the other, so a partial seen by one view still merges.
+	// a person holding a candidate of the same joint in a view of the partial is another person of the cluster
+	const SkelDef& def = GetSkelDef(m_type);
+	const PersonStore::Person person = m_persons[pIdx];
+	const Eigen::Matrix4Xf& skel3d = m_skels3d[pIdx];
+	const std::vector<int>& views = m_clusterViews[cluster];
+	for (int i = 0; i < views.size(); i++)
+		for (int jIdx = 0; jIdx < def.jointSize; jIdx++)
+			if (partial(jIdx, i) != -1 && person(jIdx, views[i]) != -1)
+				return FLT_MAX;
+
+	float dist = 0.f;
+	int cnt = 0;
+	for (int view = 0; view < m_cams.size(); view++) {
+		for (int jIdx = 0; jIdx < def.jointSize; jIdx++) {
+			if (person(jIdx, view) != -1 && partialSkel3d(3, jIdx) > FLT_EPSILON) {
+				dist += Point2LineDist(partialSkel3d.col(jIdx).head(3), m_camPositions[view], GetJointRays(view, jIdx).col(person(jIdx, view)));
+				cnt++;
+			}
+		}
+	}
+	for (int i = 0; i < views.size(); i++) {
+		for (int jIdx = 0; jIdx < def.jointSize; jIdx++) {
+			if (partial(jIdx, i) != -1 && skel3d(3, jIdx) > FLT_EPSILON) {
+				dist += Point2LineDist(skel3d.col(jIdx).head(3) / skel3d(3, jIdx), m_camPositions[views[i]], GetJointRays(views[i], jIdx).col(partial(jIdx, i)));
+				cnt++;
+			}
+		}
+	}
+	return cnt > 0 ? dist / float(cnt) : FLT_MAX;
+}
+
+
+int HierarchicalAssociater::FindMerge(const int& cluster, const PersonStore::ConstPerson& partial, const Eigen::Matrix4Xf& partialSkel3d)
+{
+	int pIdx = -1;
+	float minDist = m_maxMergeDist;
+	for (int mergeIdx = m_persons.Begin(); mergeIdx != m_persons.End(); mergeIdx = m_persons.Next(mergeIdx)) {
+		const float dist = CalcMergeDist(mergeIdx, cluster, partial, partialSkel3d);
+		if (dist < minDist) {
+			minDist = dist;
+			pIdx = mergeIdx;
+		}
+	}
+	return pIdx;
+}
+
+
+void HierarchicalAssociater::Associate()
+{
+	const SkelDef& def = GetSkelDef(m_type);
+	const std::chrono::steady_clock::time_point clusterStart = std::chrono::steady_clock::now();
+#pragma omp parallel for schedule(dynamic)
+	for (int cluster = 0; cluster < m_clusters.size(); cluster++) {
+		KruskalAssociater& associater = *m_clusters[cluster];
+		associater.SetMaxEpiDist(m_maxEpiDist);
+		associater.SetMaxTempDist(m_maxTempDist);
+		associater.SetMinTempDist(m_minTempDist);
+		associater.SetTempGateScale(m_tempGateScale);
+		associater.SetMinAsgnCnt(m_minAsgnCnt);
+		associater.SetNormalizeEdge(m_normalizeEdges);
+		// every view is in a single cluster, its detection is moved there and back
+		const std::vector<int>& views = m_clusterViews[cluster];
+		for (int i = 0; i < views.size(); i++)
+			associater.SetDetection(i, std::move(m_detections[views[i]]));
+		associater.SetSkels3dPrev(m_skels3dPrev, m_prevErrors);
+		associater.Associate();
+		for (int i = 0; i < views.size(); i++)
+			m_detections[views[i]] = associater.TakeDetection(i);
+	}
+	const std::chrono::steady_clock::time_point mergeStart = std::chrono::steady_clock::now();
+	m_clusterTime = std::chrono::duration<double>(mergeStart - clusterStart).count();
+	CalcJointRays();
+
+	// tracked persons keep their ids in every cluster, so only the new persons of a cluster are matched, each to
+	// a different person it does not conflict with. a person split by its own cluster is joined again this way
+	for (int view = 0; view < m_cams.size(); view++)
+		for (int jIdx = 0; jIdx < def.jointSize; jIdx++)
+			m_assignMap[view][jIdx].assign(m_detections[view].joints[jIdx].cols(), -1);
+	m_persons.Reset(def.jointSize, int(m_cams.size()));
+	for (int pIdx = 0; pIdx < m_skels3dPrev.size(); pIdx++) {
+		m_persons.Insert(pIdx);
+		if (pIdx == m_skels3d.size())
+			m_skels3d.emplace_back();
+		m_skels3d[pIdx].setZero(4, def.jointSize);
+	}
+
+	m_mergeCnt = 0;
+	m_dropCnt = 0;
+	m_deferred.clear();
+	for (int cluster = 0; cluster < m_clusters.size(); cluster++) {
+		const PersonStore& partials = m_clusters[cluster]->GetPersons();
+		m_partials.clear();
+		for (int partialIdx = partials.Begin(); partialIdx != partials.End(); partialIdx = partials.Next(partialIdx)) {
+			if (partialIdx >= m_partialSkels3d.size())
+				m_partialSkels3d.resize(partialIdx + 1);
+			TriangulatePartial(cluster, partials[partialIdx], m_partialSkels3d[partialIdx]);
+			if (partialIdx < m_skels3dPrev.size())
+				MergePartial(cluster, partials[partialIdx], m_partialSkels3d[partialIdx], partialIdx);
+			else
+				m_partials.emplace_back(partialIdx);
+		}
+
+		m_mergeIdxs.clear();
+		for (int pIdx = m_persons.Begin(); pIdx != m_persons.End(); pIdx = m_persons.Next(pIdx))
+			m_mergeIdxs.emplace_back(pIdx);
+
+		if (!m_partials.empty() && !m_mergeIdxs.empty()) {
+			Eigen::MatrixXf dists(m_partials.size(), m_mergeIdxs.size());
+			for (int row = 0; row < m_partials.size(); row++)
+				for (int col = 0; col < m_mergeIdxs.size(); col++)
+					dists(row, col) = std::min(m_maxMergeDist, CalcMergeDist(m_mergeIdxs[col], cluster, partials[m_partials[row]], m_partialSkels3d[m_partials[row]]));
+			for (const auto& matchPair : HungarianAlgorithm(dists)) {
+				if (matchPair.first < m_maxMergeDist) {
+					int& partialIdx = m_partials[matchPair.second.x()];
+					MergePartial(cluster, partials[partialIdx], m_partialSkels3d[partialIdx], m_mergeIdxs[matchPair.second.y()]);
+					partialIdx = -1;
+					m_mergeCnt++;
+				}
+			}
+		}
+
+		// the rest are new persons, unless a partial is a fragment of a person the cluster did not join, the one to one
+		// matching leaves those over as the main part took the person
+		m_partials.erase(std::remove(m_partials.begin(), m_partials.end(), -1), m_partials.end());
+		std::stable_sort(m_partials.begin(), m_partials.end(), [&partials](const int& partialA, const int& partialB) {
+			return (partials[partialA].array() != -1).count() > (partials[partialB].array() != -1).count(); });
+		for (const int& partialIdx : m_partials) {
+			int pIdx = FindMerge(cluster, partials[partialIdx], m_partialSkels3d[partialIdx]);
+			if (pIdx != -1)
+				m_mergeCnt++;
+			else if ((m_partialSkels3d[partialIdx].row(3).array() > FLT_EPSILON).count() < m_minNewJointCnt) {
+				m_deferred.emplace_back(cluster, partialIdx);
+				continue;
+			}
+			else {
+				pIdx = m_persons.End();
+				m_persons.Insert(pIdx);
+				if (pIdx == m_skels3d.size())
+					m_skels3d.emplace_back();
+				m_skels3d[pIdx].setZero(4, def.jointSize);
+			}
+			MergePartial(cluster, partials[partialIdx], m_partialSkels3d[partialIdx], pIdx);
+		}
+	}
+
+	// a partial that can not be located in 3d may still belong to a person of a later cluster
+	Eigen::Matrix4Xf partialSkel3d;
+	for (const auto& deferred : m_deferred) {
+		const PersonStore::ConstPerson partial = m_clusters[deferred.first]->GetPersons()[deferred.second];
+		TriangulatePartial(deferred.first, partial, partialSkel3d);
+		const int pIdx = FindMerge(deferred.first, partial, partialSkel3d);
+		if (pIdx != -1) {
+			MergePartial(deferred.first, partial, partialSkel3d, pIdx);
+			m_mergeCnt++;
+		}
+		else
+			m_dropCnt++;
+	}
+
+	CalcSkels2d();
+	m_mergeTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - mergeStart).count();
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <memory>
+#include "kruskal_associater.h"
+
+
+// two level association for rigs too large to enumerate cliques over all views. the cameras are split into clusters,
+// each associated on its own by a KruskalAssociater in parallel, and the partial persons of the clusters are merged
+// by the distance of their triangulated joints. tracked persons merge by identity
+class HierarchicalAssociater : public Associater
+{
+public:
+	// clusters[view], e.g. from ClusterCameras
+	HierarchicalAssociater(const SkelType& type, const std::map<std::string, Camera>& cams, const std::vector<int>& clusters);
+	virtual void Associate() override;
+
+	// the clusters take the epi and temp distances, temporal gate, min assign count and edge normalization of this
+	// associater every frame, the rest is set on them directly
+	int GetClusterSize() const { return int(m_clusters.size()); }
+	KruskalAssociater& GetCluster(const int& cluster) { return *m_clusters[cluster]; }
+	const std::vector<int>& GetClusterViews(const int& cluster) const { return m_clusterViews[cluster]; }
+
+	// partial persons further apart than the max merge distance stay apart, in mean distance of the triangulated joints
+	// of either to the joint rays of the other
+	void SetMaxMergeDist(const float& _maxMergeDist) { m_maxMergeDist = _maxMergeDist; }
+	// partial joints are triangulated if their mean distance to the rays is below the thresh
+	void SetTriangulateThresh(const float& _triangulateThresh) { m_triangulateThresh = _triangulateThresh; }
+	// a partial merging into no person only becomes a new person with at least the min triangulated joints. the
+	// others, e.g. persons seen by a single view of their cluster, are retried against the persons of all clusters
+	// and dropped if they still match none
+	void SetMinNewJointCnt(const int& _minNewJointCnt) { m_minNewJointCnt = _minNewJointCnt; }
+	int GetDropCnt() const { return m_dropCnt; }
+	int GetMergeCnt() const { return m_mergeCnt; }
+	double GetClusterTime() const { return m_clusterTime; }		// seconds associating the clusters in the last frame
+	double GetMergeTime() const { return m_mergeTime; }			// seconds merging them
+
+private:
+	float m_maxMergeDist = 0.2f;
+	float m_triangulateThresh = 0.05f;
+	int m_minNewJointCnt = 6;
+	int m_mergeCnt = 0;
+	int m_dropCnt = 0;
+	double m_clusterTime = 0.;
+	double m_mergeTime = 0.;
+
+	std::vector<std::unique_ptr<KruskalAssociater>> m_clusters;
+	std::vector<std::vector<int>> m_clusterViews;				// m_clusterViews[cluster], its views ascending
+	std::vector<Eigen::Vector3f> m_camPositions;				// m_camPositions[view]
+
+	std::vector<Eigen::Matrix4Xf> m_skels3d;					// m_skels3d[pIdx], sum of the partial joints and their count
+	std::vector<int> m_partials;								// new persons of a cluster
+	std::vector<Eigen::Matrix4Xf> m_partialSkels3d;
+	std::vector<int> m_mergeIdxs;
+	std::vector<std::pair<int, int>> m_deferred;				// (cluster, partialIdx) of partials too weak for a new person
+
+	void TriangulatePartial(const int& cluster, const PersonStore::ConstPerson& partial, Eigen::Matrix4Xf& skel3d);
+	void MergePartial(const int& cluster, const PersonStore::ConstPerson& partial, const Eigen::Matrix4Xf& skel3d, const int& pIdx);
+	int FindMerge(const int& cluster, const PersonStore::ConstPerson& partial, const Eigen::Matrix4Xf& partialSkel3d);
+	float CalcMergeDist(const int& pIdx, const int& cluster, const PersonStore::ConstPerson& partial, const Eigen::Matrix4Xf& partialSkel3d);
+};
@@ -1,10 +1,65 @@
 #include <Eigen/Eigen>
 #include <opencv2/opencv.hpp>
 #include <sstream>
+#include <cstdint>
 #include <numeric>
 #include <algorithm>
 #include "kruskal_associater.h"
 #include "math_util.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+// candidate sets as bitsets of 64 bit words
+namespace
+{
+	inline int BitWords(const int& size) { return (size + 63) / 64; }
+	inline void SetBit(uint64_t* bits, const int& i) { bits[i / 64] |= uint64_t(1) << (i % 64); }
+
+	inline int LowestBit(const uint64_t& word)
+	{
+#if defined(_MSC_VER) && defined(_WIN64)
+		unsigned long i;
+		_BitScanForward64(&i, word);
+		return int(i);
+#elif defined(_MSC_VER)
+		unsigned long i;
+		if (_BitScanForward(&i, static_cast<unsigned long>(word)))
+			return int(i);
+		_BitScanForward(&i, static_cast<unsigned long>(word >> 32));
+		return int(i) + 32;
+#else
+		return __builtin_ctzll(word);
+#endif
+	}
+
+	// first set bit at or after from, none if there is no such bit
+	inline int NextBit(const uint64_t* bits, const int& wordSize, const int& from, const int& none)
+	{
+		for (int w = from / 64; w < wordSize; w++) {
+			const uint64_t word = w == from / 64 ? bits[w] & (~uint64_t(0) << (from % 64)) : bits[w];
+			if (word != 0)
+				return w * 64 + LowestBit(word);
+		}
+		return none;
+	}
+}
+
+
+// a positive edge from row to col, walking the real edges of the row, its neighbours are ascending
+namespace
+{
+	inline bool HasEdge(const EdgeGraph::View& edges, const int& row, const int& col)
+	{
+		for (int i = edges.GetBegin(row); i < edges.GetEnd(row); i++) {
+			const int neighbor = edges.GetNeighbor(i);
+			if (neighbor >= col)
+				return neighbor == col && edges.GetWeight(i) > 0.f;
+		}
+		return false;
+	}
+}
 
 
 KruskalAssociater::KruskalAssociater(const SkelType& type, const std::map<std::string, Camera>& cams)
@@ -24,13 +79,54 @@ KruskalAssociater::KruskalAssociater(const SkelType& type, const std::map<std::s
 	m_pafHierSize = m_pafHier.maxCoeff();
 
 	m_boneNodes.resize(def.pafSize, std::vector<std::vector<Eigen::Vector2i>>(m_cams.size()));
-	m_boneEpiEdges.resize(def.pafSize, std::vector<std::vector<Eigen::MatrixXf>>(m_cams.size(), std::vector<Eigen::MatrixXf>(m_cams.size())));
-	m_boneTempEdges.resize(def.pafSize, std::vector<Eigen::MatrixXf>(m_cams.size()));
+	m_boneEpiEdges.resize(def.pafSize, std::vector<std::vector<EdgeGraph>>(m_cams.size(), std::vector<EdgeGraph>(m_cams.size())));
+	m_boneTempEdges.resize(def.pafSize, std::vector<EdgeGraph>(m_cams.size()));
+	m_cliqueBits.resize(def.pafSize);
+	m_pafProposals.resize(def.pafSize);
+	m_pafScores.resize(def.pafSize);
+}
+
+
+void KruskalAssociater::ClaimTracked()
+{
+	const SkelDef& def = GetSkelDef(m_type);
+	int fastPathCnt = 0;
+	for (int pIdx = 0; pIdx < m_skels3dPrev.size(); pIdx++) {
+		PersonStore::Person person = m_persons[pIdx];
+		int edgeCnt = 0, claimCnt = 0;
+		for (int jIdx = 0; jIdx < def.jointSize; jIdx++) {
+			for (int view = 0; view < m_cams.size(); view++) {
+				const EdgeGraph::View rows = m_tempEdges[jIdx][view].Rows();
+				const EdgeGraph::View cols = m_tempEdges[jIdx][view].Cols();
+				if (rows.GetBegin(pIdx) == rows.GetEnd(pIdx))
+					continue;
+				edgeCnt++;
+				const int jCandiIdx = rows.GetNeighbor(rows.GetBegin(pIdx));
+				if (rows.GetEnd(pIdx) - rows.GetBegin(pIdx) == 1 && cols.GetEnd(jCandiIdx) - cols.GetBegin(jCandiIdx) == 1) {
+					person(jIdx, view) = jCandiIdx;
+					claimCnt++;
+				}
+			}
+		}
+
+		// a person too ambiguous to fast path gives its claims back to the search
+		if (claimCnt == 0 || float(claimCnt) < m_minClaimRatio * float(edgeCnt)) {
+			person.setConstant(-1);
+			continue;
+		}
+		for (int view = 0; view < m_cams.size(); view++)
+			for (int jIdx = 0; jIdx < def.jointSize; jIdx++)
+				if (person(jIdx, view) != -1)
+					m_assignMap[view][jIdx][person(jIdx, view)] = pIdx;
+		fastPathCnt++;
+	}
+	m_fastPathRatio = m_skels3dPrev.empty() ? 0.f : float(fastPathCnt) / float(m_skels3dPrev.size());
 }
 
 
 void KruskalAssociater::CalcBoneNodes()
 {
+	// bones of two claimed joints are already assigned, one claimed joint still joins the other to its person
 	const SkelDef& def = GetSkelDef(m_type);
 #pragma omp parallel for
 	for (int pafIdx = 0; pafIdx < def.pafSize; pafIdx++) {
@@ -38,9 +134,12 @@ void KruskalAssociater::CalcBoneNodes()
 		const int jbIdx = def.pafDict(1, pafIdx);
 		for (int view = 0; view < m_cams.size(); view++) {
 			m_boneNodes[pafIdx][view].clear();
+			const std::vector<int>& jaAssigns = m_assignMap[view][jaIdx];
+			const std::vector<int>& jbAssigns = m_assignMap[view][jbIdx];
 			for (int jaCandiIdx = 0; jaCandiIdx < m_detections[view].joints[jaIdx].cols(); jaCandiIdx++)
 				for (int jbCandiIdx = 0; jbCandiIdx < m_detections[view].joints[jbIdx].cols(); jbCandiIdx++)
-					if (m_detections[view].pafs[pafIdx](jaCandiIdx, jbCandiIdx) > FLT_EPSILON)
+					if (m_detections[view].pafs[pafIdx](jaCandiIdx, jbCandiIdx) > FLT_EPSILON
+						&& (jaAssigns[jaCandiIdx] == -1 || jbAssigns[jbCandiIdx] == -1))
 						m_boneNodes[pafIdx][view].emplace_back(Eigen::Vector2i(jaCandiIdx, jbCandiIdx));
 		}
 	}
@@ -54,32 +153,38 @@ void KruskalAssociater::CalcBoneEpiEdges()
 	for (int pafIdx = 0; pafIdx < def.pafSize; pafIdx++) {
 		const Eigen::Vector2i jIdxPair = def.pafDict.col(pafIdx).transpose();
 		for (int viewA = 0; viewA < m_cams.size() - 1; viewA++) {
-			for (int viewB = viewA + 1; viewB < m_cams.size(); viewB++) {
-				Eigen::MatrixXf& epi = m_boneEpiEdges[pafIdx][viewA][viewB];
+			for (const int& viewB : m_viewSuccessors[viewA]) {
+				EdgeGraph& epi = m_boneEpiEdges[pafIdx][viewA][viewB];
 				const auto& nodesA = m_boneNodes[pafIdx][viewA];
 				const auto& nodesB = m_boneNodes[pafIdx][viewB];
-				epi.setConstant(nodesA.size(), nodesB.size(), -1.f);
-				for (int boneAIdx = 0; boneAIdx < epi.rows(); boneAIdx++) {
-					for (int boneBIdx = 0; boneBIdx < epi.cols(); boneBIdx++) {
-						const Eigen::Vector2i& nodeA = nodesA[boneAIdx];
-						const Eigen::Vector2i& nodeB = nodesB[boneBIdx];
-
-						Eigen::Vector2f epiDist;
-						Eigen::Matrix<float, 3, 2> normals;
-						for (int i = 0; i < 2; i++) {
-							normals.col(i) = m_jointRays[viewA][jIdxPair[i]].col(nodeA[i]).cross(
-								m_jointRays[viewB][jIdxPair[i]].col(nodeB[i])).normalized();
-							epiDist[i] = m_epiEdges[jIdxPair[i]][viewA][viewB](nodeA[i], nodeB[i]);
+				const EdgeGraph::View epiJa = m_epiEdges[jIdxPair[0]][viewA][viewB].Rows();
+				const EdgeGraph& epiJb = m_epiEdges[jIdxPair[1]][viewA][viewB];
+
+				// bone nodes are generated ordered by their first joint, so the bones of view B sharing it are contiguous.
+				// only those whose first joint has an epipolar edge to the first joint of bone A are visited.
+				const int jaCandiSize = int(m_detections[viewB].joints[jIdxPair[0]].cols());
+				thread_local std::vector<int> boneBegin;
+				boneBegin.assign(jaCandiSize + 1, 0);
+				for (const Eigen::Vector2i& nodeB : nodesB)
+					boneBegin[nodeB[0] + 1]++;
+				for (int jaCandiIdx = 0; jaCandiIdx < jaCandiSize; jaCandiIdx++)
+					boneBegin[jaCandiIdx + 1] += boneBegin[jaCandiIdx];
+
+				thread_local std::vector<EdgeGraph::Edge> edges;
+				edges.clear();
+				for (int boneAIdx = 0; boneAIdx < nodesA.size() && !nodesB.empty(); boneAIdx++) {
+					const Eigen::Vector2i& nodeA = nodesA[boneAIdx];
+					for (int i = epiJa.GetBegin(nodeA[0]); i < epiJa.GetEnd(nodeA[0]); i++) {
+						const int jaCandiIdx = epiJa.GetNeighbor(i);
+						for (int boneBIdx = boneBegin[jaCandiIdx]; boneBIdx < boneBegin[jaCandiIdx + 1]; boneBIdx++) {
+							const Eigen::Vector2f epiDist(epiJa.GetWeight(i), epiJb(nodeA[1], nodesB[boneBIdx][1]));
+							if (epiDist.minCoeff() < 0.f)
+								continue;
+							edges.emplace_back(EdgeGraph::Edge{ boneAIdx, boneBIdx, epiDist.mean() });
 						}
-
-						if (epiDist.minCoeff() < 0.f)
-							continue;
-
-						const float cosine = fabsf(normals.col(0).dot(normals.col(1)));
-						epi(boneAIdx, boneBIdx) = epiDist.mean();
 					}
 				}
-				m_boneEpiEdges[pafIdx][viewB][viewA] = epi.transpose();
+				epi.Build(int(nodesA.size()), int(nodesB.size()), edges);
 			}
 		}
 	}
@@ -93,153 +198,361 @@ void KruskalAssociater::CalcBoneTempEdges()
 	for (int pafIdx = 0; pafIdx < def.pafSize; pafIdx++) {
 		const Eigen::Vector2i jIdxPair = def.pafDict.col(pafIdx).transpose();
 		for (int view = 0; view < m_cams.size(); view++) {
-			Eigen::MatrixXf& temp = m_boneTempEdges[pafIdx][view];
+			EdgeGraph& temp = m_boneTempEdges[pafIdx][view];
 			const auto& nodes = m_boneNodes[pafIdx][view];
-			temp.setConstant(m_skels3dPrev.size(), nodes.size(), -1.f);
-			for (int pIdx = 0; pIdx < temp.rows(); pIdx++) {
-				for (int jCandiIdx = 0; jCandiIdx < temp.cols(); jCandiIdx++) {
-					const Eigen::Vector2i& node = nodes[jCandiIdx];
-					Eigen::Vector2f tempDist;
-					for (int i = 0; i < 2; i++)
-						tempDist[i] = m_tempEdges[jIdxPair[i]][view](pIdx, node[i]);
-
+			const EdgeGraph::View tempJa = m_tempEdges[jIdxPair[0]][view].Cols();
+			const EdgeGraph& tempJb = m_tempEdges[jIdxPair[1]][view];
+			thread_local std::vector<EdgeGraph::Edge> edges;
+			edges.clear();
+			for (int boneIdx = 0; boneIdx < nodes.size() && !m_skels3dPrev.empty(); boneIdx++) {
+				const Eigen::Vector2i& node = nodes[boneIdx];
+				for (int i = tempJa.GetBegin(node[0]); i < tempJa.GetEnd(node[0]); i++) {
+					const int pIdx = tempJa.GetNeighbor(i);
+					const Eigen::Vector2f tempDist(tempJa.GetWeight(i), tempJb(pIdx, node[1]));
 					if (tempDist.minCoeff() > 0.f)
-						temp(pIdx, jCandiIdx) = tempDist.mean();
+						edges.emplace_back(EdgeGraph::Edge{ pIdx, boneIdx, tempDist.mean() });
 				}
 			}
+			temp.Build(int(m_skels3dPrev.size()), int(nodes.size()), edges);
 		}
 	}
 }
    
          
-void KruskalAssociater::EnumCliques(std::vector<BoneClique>& cliques)
+void KruskalAssociater::CalcCliqueBits()
 {
-	// enum cliques
 	const SkelDef& def = GetSkelDef(m_type);
+	const int viewSize = int(m_cams.size());
 
-	std::vector<std::vector<BoneClique>> tmpCliques(def.pafSize);
 #pragma omp parallel for
 	for (int pafIdx = 0; pafIdx < def.pafSize; pafIdx++) {
-		const auto jIdxPair = def.pafDict.col(pafIdx);
 		const auto& nodes = m_boneNodes[pafIdx];
-		Eigen::VectorXi pick = -Eigen::VectorXi::Ones(m_cams.size() + 1);
-		std::vector<std::vector<std::list<int>>> availNodes(pick.size(), std::vector<std::list<int>>(pick.size()));
+		CliqueBits& cliqueBits = m_cliqueBits[pafIdx];
+
+		// candidates of a view (or the persons, as the last view) are bitsets of wordSize words
+		int& wordSize = cliqueBits.wordSize;
+		wordSize = BitWords(int(m_skels3dPrev.size()));
+		for (int view = 0; view < viewSize; view++)
+			wordSize = std::max(wordSize, BitWords(int(nodes[view].size())));
+
+		// epipolar adjacency: per bone of viewA the bones of viewB it has an edge with, viewA < viewB
+		std::vector<int>& epiOffsets = cliqueBits.epiOffsets;
+		std::vector<uint64_t>& epiBits = cliqueBits.epiBits;
+		epiOffsets.resize(viewSize * viewSize);
+		int epiBitSize = 0;
+		for (int viewA = 0; viewA < viewSize - 1; viewA++) {
+			for (int viewB = viewA + 1; viewB < viewSize; viewB++) {
+				epiOffsets[viewA * viewSize + viewB] = epiBitSize;
+				epiBitSize += int(nodes[viewA].size()) * wordSize;
+			}
+		}
+		// unpaired views have no bits, their bones never share a clique
+		epiBits.assign(epiBitSize, 0);
+		cliqueBits.maxEpi = 0.f;
+		for (int viewA = 0; viewA < viewSize - 1; viewA++) {
+			for (const int& viewB : m_viewSuccessors[viewA]) {
+				const EdgeGraph::View epiEdges = m_boneEpiEdges[pafIdx][viewA][viewB].Rows();
+				for (int boneAIdx = 0; boneAIdx < nodes[viewA].size(); boneAIdx++) {
+					uint64_t* bits = epiBits.data() + epiOffsets[viewA * viewSize + viewB] + boneAIdx * wordSize;
+					for (int i = epiEdges.GetBegin(boneAIdx); i < epiEdges.GetEnd(boneAIdx); i++) {
+						if (epiEdges.GetWeight(i) > FLT_EPSILON) {
+							SetBit(bits, epiEdges.GetNeighbor(i));
+							cliqueBits.maxEpi = std::max(cliqueBits.maxEpi, epiEdges.GetWeight(i));
+						}
+					}
+				}
+			}
+		}
+
+		// temporal adjacency: per bone of the last view the persons it has an edge with
+		std::vector<uint64_t>& tempBits = cliqueBits.tempBits;
+		const EdgeGraph::View tempEdges = m_boneTempEdges[pafIdx][viewSize - 1].Cols();
+		tempBits.assign(nodes[viewSize - 1].size() * wordSize, 0);
+		for (int boneIdx = 0; boneIdx < nodes[viewSize - 1].size(); boneIdx++)
+			for (int i = tempEdges.GetBegin(boneIdx); i < tempEdges.GetEnd(boneIdx); i++)
+				if (tempEdges.GetWeight(i) > FLT_EPSILON)
+					SetBit(tempBits.data() + boneIdx * wordSize, tempEdges.GetNeighbor(i));
+
+		cliqueBits.maxTemp = 0.f;
+		for (int view = 0; view < viewSize; view++) {
+			const EdgeGraph::View edges = m_boneTempEdges[pafIdx][view].Rows();
+			for (int pIdx = 0; pIdx < edges.GetRows(); pIdx++)
+				for (int i = edges.GetBegin(pIdx); i < edges.GetEnd(pIdx); i++)
+					cliqueBits.maxTemp = std::max(cliqueBits.maxTemp, edges.GetWeight(i));
+		}
+	}
+}
+
+
+void KruskalAssociater::CalcComponents()
+{
+	// candidates and tracked persons linked by any paf, epipolar or temporal edge end up in one component. the
+	// assignment only ever relates those, so components share neither cliques nor persons
+	const SkelDef& def = GetSkelDef(m_type);
+	const int nodeSize = m_candiSize + int(m_skels3dPrev.size());
+	m_componentParents.resize(nodeSize);
+	std::iota(m_componentParents.begin(), m_componentParents.end(), 0);
+	m_componentLabels.assign(nodeSize, -1);
+	auto Node = [&](const int& view, const int& jIdx, const int& candiIdx) {
+		return m_viewCandiOffsets[view] + m_jointRayOffsets[view][jIdx] + candiIdx; };
+	auto Unite = [&](const int& a, const int& b) {
+		const int rootA = GetComponent(a);
+		const int rootB = GetComponent(b);
+		if (rootA != rootB)
+			m_componentParents[std::max(rootA, rootB)] = std::min(rootA, rootB);
+	};
+
+	for (int view = 0; view < m_cams.size(); view++) {
+		for (int pafIdx = 0; pafIdx < def.pafSize; pafIdx++) {
+			const Eigen::MatrixXf& paf = m_detections[view].pafs[pafIdx];
+			for (int jaCandiIdx = 0; jaCandiIdx < paf.rows(); jaCandiIdx++)
+				for (int jbCandiIdx = 0; jbCandiIdx < paf.cols(); jbCandiIdx++)
+					if (paf(jaCandiIdx, jbCandiIdx) > 0.f)
+						Unite(Node(view, def.pafDict(0, pafIdx), jaCandiIdx), Node(view, def.pafDict(1, pafIdx), jbCandiIdx));
+		}
+	}
+
+	for (int jIdx = 0; jIdx < def.jointSize; jIdx++) {
+		for (int viewA = 0; viewA < m_cams.size(); viewA++) {
+			for (const int& viewB : m_viewSuccessors[viewA]) {
+				const EdgeGraph::View epi = GetEpiEdges(jIdx, viewA, viewB);
+				for (int candiAIdx = 0; candiAIdx < epi.GetRows(); candiAIdx++)
+					for (int i = epi.GetBegin(candiAIdx); i < epi.GetEnd(candiAIdx); i++)
+						Unite(Node(viewA, jIdx, candiAIdx), Node(viewB, jIdx, epi.GetNeighbor(i)));
+			}
+
+			const EdgeGraph::View temp = m_tempEdges[jIdx][viewA].Rows();
+			for (int pIdx = 0; pIdx < temp.GetRows(); pIdx++)
+				for (int i = temp.GetBegin(pIdx); i < temp.GetEnd(pIdx); i++)
+					Unite(m_candiSize + pIdx, Node(viewA, jIdx, temp.GetNeighbor(i)));
+		}
+	}
+}
+
 
-		int viewCnt = 0;
+int KruskalAssociater::GetComponent(const int& node)
+{
+	int root = node;
+	while (m_componentParents[root] != root) {
+		m_componentParents[root] = m_componentParents[m_componentParents[root]];
+		root = m_componentParents[root];
+	}
+	return root;
+}
+
+
+KruskalAssociater::SpanContext& KruskalAssociater::NewSpan()
+{
+	if (m_spanSize == m_spans.size())
+		m_spans.emplace_back();
+	SpanContext& span = m_spans[m_spanSize++];
+	span.cliqueHeap.Reset(int(m_cams.size()) + 1);
+	span.persons.Reset(GetSkelDef(m_type).jointSize, int(m_cams.size()));
+	span.topProposal.resize(m_cams.size() + 1);
+	span.proposal.resize(m_cams.size() + 1);
+	span.proposalPair.resize(m_cams.size() + 1, 2);
+	span.conflict.resize(m_cams.size());
+	std::fill(span.personSlots.begin(), span.personSlots.end(), -1);
+	span.personSlotSize = 0;
+	span.candiSize = 0;
+	span.jointCacheHitCnt = span.jointCacheMissCnt = span.personCacheHitCnt = span.personCacheMissCnt = 0;
+	span.popCnt = 0;
+	return span;
+}
+
+
+void KruskalAssociater::EnumCliques(const bool& split)
+{
+	// enum cliques
+	const SkelDef& def = GetSkelDef(m_type);
+	const int viewSize = int(m_cams.size());
+
+#pragma omp parallel for
+	for (int pafIdx = 0; pafIdx < def.pafSize; pafIdx++) {
+		const auto& nodes = m_boneNodes[pafIdx];
+		std::vector<int>& proposals = m_pafProposals[pafIdx];
+		std::vector<float>& scores = m_pafScores[pafIdx];
+		proposals.clear();
+		scores.clear();
+
+		const CliqueBits& cliqueBits = m_cliqueBits[pafIdx];
+		const int& wordSize = cliqueBits.wordSize;
+		const std::vector<int>& epiOffsets = cliqueBits.epiOffsets;
+		const std::vector<uint64_t>& epiBits = cliqueBits.epiBits;
+		const std::vector<uint64_t>& tempBits = cliqueBits.tempBits;
+
+		// available nodes of every level, a level picks a node of its view and constrains the views after it
+		thread_local std::vector<uint64_t> availBits;
+		thread_local Eigen::VectorXi pick;
+		pick.setConstant(viewSize + 1, -1);
+		availBits.assign(pick.size() * pick.size() * wordSize, 0);
+		auto Avail = [&](const int& index, const int& view) { return availBits.data() + (index * pick.size() + view) * wordSize; };
+		for (int view = 0; view < viewSize; view++)
+			for (int boneIdx = 0; boneIdx < nodes[view].size(); boneIdx++)
+				SetBit(Avail(0, view), boneIdx);
+		for (int pIdx = 0; pIdx < m_skels3dPrev.size(); pIdx++)
+			SetBit(Avail(0, viewSize), pIdx);
+
+		// pick[index]: -1 skips the view, otherwise the picked node, NONE when the level is exhausted
+		const int NONE = -2;
 		int index = -1;
 		while (true) {
-			if (index >= 0 && pick[index] >= int(availNodes[index][index].size())) {
+			if (index >= 0 && pick[index] == NONE) {
 				pick[index] = -1;
 
 				if (--index < 0)
 					break;
 
-				pick[index]++;
+				pick[index] = NextBit(Avail(index, index), wordSize, pick[index] + 1, NONE);
 			}
 			else if (index == pick.size() - 1) {
-				if (-pick.head(m_cams.size()).sum() != m_cams.size()) {
-					BoneClique clique;
-					clique.pafIdx = pafIdx;
-					clique.proposal.setConstant(pick.size(), -1);
-					for (int i = 0; i < pick.size(); i++)
-						if (pick[i] != -1)
-							clique.proposal[i] = *std::next(availNodes[i][i].begin(), pick[i]);
-
+				if (-pick.head(viewSize).sum() != viewSize) {
+					proposals.insert(proposals.end(), pick.data(), pick.data() + pick.size());
+					BoneClique clique(pafIdx, Eigen::Map<Eigen::VectorXi>(proposals.data() + proposals.size() - pick.size(), pick.size()));
 					CalcCliqueScore(clique);
-					tmpCliques[pafIdx].emplace_back(clique);
+					scores.emplace_back(clique.score);
 				}
-				pick[index]++;
+				pick[index] = NextBit(Avail(index, index), wordSize, pick[index] + 1, NONE);
 			}
 			else {
 				index++;
 
 				// update available nodes
-				if (index == 0) {
-					for (int view = 0; view < m_cams.size(); view++) {
-						const auto& asgnMap = m_assignMap[view];
-						for (int bone = 0; bone < nodes[view].size(); bone++) 
-							availNodes[0][view].emplace_back(bone);
-					}
-					for (int pIdx = 0; pIdx < m_skels3dPrev.size(); pIdx++)
-						availNodes[0].back().emplace_back(pIdx);
-				}
-				else {
+				if (index > 0) {
 					// epipolar constrain
-					if (pick[index - 1] >= 0) {
-						for (int view = index; view < m_cams.size(); view++) {
-							availNodes[index][view].clear();
-							const auto& epiEdges = m_boneEpiEdges[pafIdx][index - 1][view];
-							const int boneAIdx = *std::next(availNodes[index - 1][index - 1].begin(), pick[index - 1]);
-							const auto& asgnMap = m_assignMap[view];
-							for (const int& boneBIdx : availNodes[index - 1][view]) {
-								if (epiEdges(boneAIdx, boneBIdx) > FLT_EPSILON)
-									availNodes[index][view].emplace_back(boneBIdx);
-							}
+					for (int view = index; view < viewSize; view++) {
+						const uint64_t* prevBits = Avail(index - 1, view);
+						uint64_t* bits = Avail(index, view);
+						if (pick[index - 1] >= 0) {
+							const uint64_t* epi = epiBits.data() + epiOffsets[(index - 1) * viewSize + view] + pick[index - 1] * wordSize;
+							for (int w = 0; w < wordSize; w++)
+								bits[w] = prevBits[w] & epi[w];
 						}
+						else
+							std::copy(prevBits, prevBits + wordSize, bits);
 					}
-					else
-						for (int view = index; view < m_cams.size(); view++)
-							availNodes[index][view] = availNodes[index - 1][view];
 
 					// temporal constrain
-					if (pick[m_cams.size() - 1] >= 0) {
-						availNodes[index].back().clear();
-						const auto& tempEdge = m_boneTempEdges[pafIdx][m_cams.size() - 1];
-						const int boneIdx = *std::next(availNodes[m_cams.size() - 1][m_cams.size() - 1].begin(), pick[m_cams.size() - 1]);
-						for (const int& pIdx : availNodes[index - 1].back())
-							if (tempEdge(pIdx, boneIdx) > FLT_EPSILON)
-								availNodes[index].back().emplace_back(pIdx);
+					const uint64_t* prevBits = Avail(index - 1, viewSize);
+					uint64_t* bits = Avail(index, viewSize);
+					if (pick[viewSize - 1] >= 0) {
+						const uint64_t* temp = tempBits.data() + pick[viewSize - 1] * wordSize;
+						for (int w = 0; w < wordSize; w++)
+							bits[w] = prevBits[w] & temp[w];
 					}
 					else
-						availNodes[index].back() = availNodes[index - 1].back();
+						std::copy(prevBits, prevBits + wordSize, bits);
 				}
 			}
 		}
 	}
-	// combine
-	for (int pafIdx = 0; pafIdx < def.pafSize; pafIdx++)
-		cliques.insert(cliques.end(), tmpCliques[pafIdx].begin(), tmpCliques[pafIdx].end());
 
-	std::make_heap(cliques.begin(), cliques.end());
+	// combine, each clique into the span of its component
+	m_cliqueCnt = 0;
+	for (int pafIdx = 0; pafIdx < def.pafSize; pafIdx++) {
+		const int jaIdx = def.pafDict(0, pafIdx);
+		for (int i = 0; i < m_pafScores[pafIdx].size(); i++) {
+			const Eigen::Map<Eigen::VectorXi> proposal(m_pafProposals[pafIdx].data() + i * (viewSize + 1), viewSize + 1);
+			int label = 0;
+			if (split) {
+				int view = 0;
+				while (proposal[view] == -1)
+					view++;
+				const int root = GetComponent(m_viewCandiOffsets[view] + m_jointRayOffsets[view][jaIdx] + m_boneNodes[pafIdx][view][proposal[view]].x());
+				// the person slot is only filtered by the last view's temporal edges, a person of another component
+				// is dropped with its clique, the same bones without it are enumerated anyway
+				if (proposal[viewSize] != -1 && GetComponent(m_candiSize + proposal[viewSize]) != root)
+					continue;
+				if (m_componentLabels[root] == -1) {
+					m_componentLabels[root] = m_spanSize;
+					NewSpan();
+				}
+				label = m_componentLabels[root];
+			}
+
+			CliqueHeap& cliqueHeap = m_spans[label].cliqueHeap;
+			const int cliqueIdx = cliqueHeap.New(pafIdx);
+			cliqueHeap.Get(cliqueIdx).proposal = proposal;
+			cliqueHeap.SetScore(cliqueIdx, m_pafScores[pafIdx][i]);
+			cliqueHeap.Append(cliqueIdx);
+			m_cliqueCnt++;
+		}
+	}
+	for (int label = 0; label < m_spanSize; label++)
+		m_spans[label].cliqueHeap.MakeHeap();
+}
+
+
+void KruskalAssociater::MergeSpans()
+{
+	// tracked persons keep their ids. new persons are numbered by the score of the clique creating them, the order
+	// in which a single span would have created them
+	m_newPersons.clear();
+	for (int label = 0; label < m_spanSize; label++) {
+		const SpanContext& span = m_spans[label];
+		for (int pIdx = span.persons.Begin(); pIdx != span.persons.End(); pIdx = span.persons.Next(pIdx)) {
+			if (pIdx < m_skels3dPrev.size())
+				m_persons[pIdx] = span.persons[pIdx];
+			else
+				m_newPersons.emplace_back(std::make_tuple(-span.birthScores[pIdx], label, pIdx));
+		}
+	}
+	std::sort(m_newPersons.begin(), m_newPersons.end());
+
+	const SkelDef& def = GetSkelDef(m_type);
+	for (const auto& newPerson : m_newPersons) {
+		const int personIdx = m_persons.End();
+		PersonStore::Person person = m_persons.Insert(personIdx);
+		person = m_spans[std::get<1>(newPerson)].persons[std::get<2>(newPerson)];
+		for (int view = 0; view < m_cams.size(); view++)
+			for (int jIdx = 0; jIdx < def.jointSize; jIdx++)
+				if (person(jIdx, view) != -1)
+					m_assignMap[view][jIdx][person(jIdx, view)] = personIdx;
+	}
 }
 
 
 void KruskalAssociater::CalcCliqueScore(BoneClique& clique)
 {
 	// epipolar score
-	std::vector<float> scores;
+	float scoreSum = 0.f;
+	int scoreCnt = 0;
 	for (int viewA = 0; viewA < m_cams.size() - 1; viewA++) {
 		if (clique.proposal[viewA] == -1)
 			continue;
-		for (int viewB = viewA + 1; viewB < m_cams.size(); viewB++) {
+		for (const int& viewB : m_viewSuccessors[viewA]) {
 			if (clique.proposal[viewB] == -1)
 				continue;
-			scores.emplace_back(m_boneEpiEdges[clique.pafIdx][viewA][viewB](clique.proposal[viewA], clique.proposal[viewB]));
+			scoreSum += m_boneEpiEdges[clique.pafIdx][viewA][viewB](clique.proposal[viewA], clique.proposal[viewB]);
+			scoreCnt++;
 		}
 	}
 
-	const float epiScore = scores.empty() ? 1.f
-		: std::accumulate(scores.begin(), scores.end(), 0.f) / float(scores.size());
+	const float epiScore = scoreCnt == 0 ? 1.f : scoreSum / float(scoreCnt);
 
 	// temporal score
-	scores.clear();
+	scoreSum = 0.f;
+	scoreCnt = 0;
 	const int personIdx = clique.proposal[m_cams.size()];
 	for (int view = 0; view < m_cams.size() && personIdx != -1; view++) {
 		if (clique.proposal[view] == -1)
 			continue;
-		scores.emplace_back(m_boneTempEdges[clique.pafIdx][view](personIdx, clique.proposal[view]));
+		scoreSum += m_boneTempEdges[clique.pafIdx][view](personIdx, clique.proposal[view]);
+		scoreCnt++;
 	}
-	const float tempScore = scores.empty() ? 0.f : std::accumulate(scores.begin(), scores.end(), 0.f) / float(scores.size());
+	const float tempScore = scoreCnt == 0 ? 0.f : scoreSum / float(scoreCnt);
 
 	// paf score
-	scores.clear();
+	scoreSum = 0.f;
+	scoreCnt = 0;
 	for (int view = 0; view < m_cams.size(); view++) {
 		if (clique.proposal[view] == -1)
 			continue;
 		const Eigen::Vector2i& candi = m_boneNodes[clique.pafIdx][view][clique.proposal[view]];
-		scores.emplace_back(m_detections[view].pafs[clique.pafIdx](candi.x(), candi.y()));
+		scoreSum += m_detections[view].pafs[clique.pafIdx](candi.x(), candi.y());
+		scoreCnt++;
 	}
-	const float pafScore = std::accumulate(scores.begin(), scores.end(), 0.f) / float(scores.size());
+	const float pafScore = scoreSum / float(scoreCnt);
 
 
 	// view score
@@ -253,23 +566,357 @@ void KruskalAssociater::CalcCliqueScore(BoneClique& clique)
 }
 
 
-void KruskalAssociater::PushClique(const int& pafIdx, const Eigen::VectorXi& proposal, std::vector<BoneClique>& cliques)
+Eigen::Map<Eigen::VectorXi> KruskalAssociater::NewProposal(SpanContext& span)
+{
+	// scratch, valid until the next call
+	span.proposal.setConstant(-1);
+	return Eigen::Map<Eigen::VectorXi>(span.proposal.data(), span.proposal.size());
+}
+
+
+void KruskalAssociater::CliqueHeap::Reset(const int& proposalSize)
+{
+	m_proposalSize = proposalSize;
+	m_size = 0;
+	m_freeIdxs.clear();
+	m_heap.clear();
+	m_proposals.resize(m_pafIdxs.size() * m_proposalSize);
+}
+
+
+int KruskalAssociater::CliqueHeap::New(const int& pafIdx)
+{
+	int idx;
+	if (!m_freeIdxs.empty()) {
+		idx = m_freeIdxs.back();
+		m_freeIdxs.pop_back();
+	}
+	else {
+		idx = m_size++;
+		if (m_size > m_pafIdxs.size()) {
+			m_pafIdxs.resize(m_size);
+			m_scores.resize(m_size);
+			m_proposals.resize(m_size * m_proposalSize);
+		}
+	}
+	m_pafIdxs[idx] = pafIdx;
+	m_scores[idx] = 0.f;
+	std::fill(m_proposals.begin() + idx * m_proposalSize, m_proposals.begin() + (idx + 1) * m_proposalSize, -1);
+	return idx;
+}
+
+
+KruskalAssociater::BoneClique KruskalAssociater::CliqueHeap::Get(const int& idx)
+{
+	BoneClique clique(m_pafIdxs[idx], Eigen::Map<Eigen::VectorXi>(m_proposals.data() + idx * m_proposalSize, m_proposalSize));
+	clique.score = m_scores[idx];
+	return clique;
+}
+
+
+void KruskalAssociater::CliqueHeap::Push(const int& idx)
+{
+	m_heap.emplace_back(Entry{ m_scores[idx], idx });
+	std::push_heap(m_heap.begin(), m_heap.end());
+}
+
+
+int KruskalAssociater::CliqueHeap::Pop()
+{
+	const int idx = m_heap.front().idx;
+	std::pop_heap(m_heap.begin(), m_heap.end());
+	m_heap.pop_back();
+	return idx;
+}
+
+
+int KruskalAssociater::NewSearchSlot()
+{
+	if (!m_searchFreeSlots.empty()) {
+		const int slot = m_searchFreeSlots.back();
+		m_searchFreeSlots.pop_back();
+		return slot;
+	}
+	const int slot = m_searchSlotSize++;
+	if (m_searchPicks.size() < m_searchSlotSize * (m_cams.size() + 1)) {
+		m_searchPicks.resize(m_searchSlotSize * (m_cams.size() + 1));
+		m_searchBits.resize(m_searchSlotSize * (m_cams.size() + 1) * m_searchWordSize);
+	}
+	return slot;
+}
+
+
+void KruskalAssociater::InitCliqueSearch()
+{
+	const SkelDef& def = GetSkelDef(m_type);
+	const int viewSize = int(m_cams.size());
+	m_searchHeap.clear();
+	m_searchFreeSlots.clear();
+	m_searchSlotSize = 0;
+	m_searchWordSize = 0;
+	for (const CliqueBits& cliqueBits : m_cliqueBits)
+		m_searchWordSize = std::max(m_searchWordSize, cliqueBits.wordSize);
+	m_searchPicks.clear();
+	m_searchBits.clear();
+
+	// one root per paf, nothing decided and every node available
+	for (int pafIdx = 0; pafIdx < def.pafSize; pafIdx++) {
+		const int slot = NewSearchSlot();
+		int* picks = SearchPicks(slot);
+		uint64_t* bits = SearchBits(slot);
+		std::fill(picks, picks + viewSize + 1, -1);
+		std::fill(bits, bits + (viewSize + 1) * m_searchWordSize, 0);
+		for (int view = 0; view < viewSize; view++)
+			for (int boneIdx = 0; boneIdx < m_boneNodes[pafIdx][view].size(); boneIdx++)
+				SetBit(bits + view * m_searchWordSize, boneIdx);
+		for (int pIdx = 0; pIdx < m_skels3dPrev.size(); pIdx++)
+			SetBit(bits + viewSize * m_searchWordSize, pIdx);
+		PushSearchNode(pafIdx, 0, slot);
+	}
+}
+
+
+float KruskalAssociater::CalcCliqueBound(const int& pafIdx, const int& index, const int& slot)
+{
+	// upper bound of CalcCliqueScore over every completion of the views from index on
+	const int viewSize = int(m_cams.size());
+	const CliqueBits& cliqueBits = m_cliqueBits[pafIdx];
+	const int* picks = SearchPicks(slot);
+	const uint64_t* bits = SearchBits(slot);
+
+	float epiSum = 0.f, pafSum = 0.f;
+	int epiCnt = 0, pafCnt = 0;
+	for (int viewA = 0; viewA < index; viewA++) {
+		if (picks[viewA] == -1)
+			continue;
+		const Eigen::Vector2i& candi = m_boneNodes[pafIdx][viewA][picks[viewA]];
+		pafSum += m_detections[viewA].pafs[pafIdx](candi.x(), candi.y());
+		pafCnt++;
+		for (const int& viewB : m_viewSuccessors[viewA]) {
+			if (viewB >= index)
+				break;
+			if (picks[viewB] == -1)
+				continue;
+			epiSum += m_boneEpiEdges[pafIdx][viewA][viewB](picks[viewA], picks[viewB]);
+			epiCnt++;
+		}
+	}
+
+	int openCnt = 0;
+	float maxPaf = -FLT_MAX;
+	for (int view = index; view < viewSize; view++) {
+		const uint64_t* viewBits = bits + view * m_searchWordSize;
+		int boneIdx = NextBit(viewBits, cliqueBits.wordSize, 0, -1);
+		if (boneIdx < 0)
+			continue;
+		openCnt++;
+		for (; boneIdx >= 0; boneIdx = NextBit(viewBits, cliqueBits.wordSize, boneIdx + 1, -1)) {
+			const Eigen::Vector2i& candi = m_boneNodes[pafIdx][view][boneIdx];
+			maxPaf = std::max(maxPaf, m_detections[view].pafs[pafIdx](candi.x(), candi.y()));
+		}
+	}
+
+	// no view can be picked anymore
+	if (pafCnt + openCnt == 0)
+		return -FLT_MAX;
+
+	// a mean over more terms stays below the larger of the current mean and the best new term
+	const float epiScore = epiCnt == 0 ? std::max(1.f, cliqueBits.maxEpi)
+		: std::max(epiSum / float(epiCnt), openCnt > 0 ? cliqueBits.maxEpi : -FLT_MAX);
+	const bool personOpen = NextBit(bits + viewSize * m_searchWordSize, cliqueBits.wordSize, 0, -1) >= 0;
+	const float tempScore = personOpen ? std::max(0.f, cliqueBits.maxTemp) : 0.f;
+	const float pafScore = std::max(pafCnt == 0 ? -FLT_MAX : pafSum / float(pafCnt), maxPaf);
+	const float viewScore = MathUtil::Welsch(m_cViewCnt, float(pafCnt + openCnt));
+	const float hierScore = 1.f - powf(float(m_pafHier[pafIdx]) / float(m_pafHierSize), 4);
+
+	return (m_wEpi * epiScore + m_wTemp * tempScore + m_wPaf * pafScore + m_wView * viewScore + m_wHier * hierScore)
+		/ (m_wEpi + m_wTemp + m_wPaf + m_wView + m_wHier);
+}
+
+
+void KruskalAssociater::PushSearchNode(const int& pafIdx, const int& index, const int& slot)
+{
+	SearchNode node;
+	node.pafIdx = pafIdx;
+	node.index = index;
+	node.slot = slot;
+	if (index == m_cams.size() + 1) {
+		// a complete proposal is keyed by its exact score
+		BoneClique clique(pafIdx, Eigen::Map<Eigen::VectorXi>(SearchPicks(slot), m_cams.size() + 1));
+		if (-clique.proposal.head(m_cams.size()).sum() == m_cams.size()) {
+			m_searchFreeSlots.emplace_back(slot);
+			return;
+		}
+		CalcCliqueScore(clique);
+		node.bound = clique.score;
+	}
+	else {
+		node.bound = CalcCliqueBound(pafIdx, index, slot);
+		if (node.bound == -FLT_MAX) {
+			m_searchFreeSlots.emplace_back(slot);
+			return;
+		}
+	}
+	m_searchHeap.emplace_back(node);
+	std::push_heap(m_searchHeap.begin(), m_searchHeap.end());
+}
+
+
+bool KruskalAssociater::SearchClique(SpanContext& span, const float& minScore)
+{
+	// expands the best partial proposal until a complete one comes out on top, which no other proposal can beat
+	const int viewSize = int(m_cams.size());
+	const long long nodeBudget = m_nodeBudget > 0 ? m_nodeBudget : (long long)(m_cliqueBudget) * (viewSize + 1);
+	while (!m_searchHeap.empty() && m_searchHeap.front().bound > minScore) {
+		if ((m_cliqueBudget > 0 && (m_cliqueCnt >= m_cliqueBudget || m_nodeCnt >= nodeBudget)) || (m_cliqueTimeBudget > 0.f
+			&& std::chrono::duration<float>(std::chrono::steady_clock::now() - m_searchStart).count() > m_cliqueTimeBudget)) {
+			m_budgetHit = true;
+			return false;
+		}
+
+		std::pop_heap(m_searchHeap.begin(), m_searchHeap.end());
+		const SearchNode node = m_searchHeap.back();
+		m_searchHeap.pop_back();
+
+		if (node.index == viewSize + 1) {
+			const int cliqueIdx = span.cliqueHeap.New(node.pafIdx);
+			span.cliqueHeap.Get(cliqueIdx).proposal = Eigen::Map<Eigen::VectorXi>(SearchPicks(node.slot), viewSize + 1);
+			span.cliqueHeap.SetScore(cliqueIdx, node.bound);
+			span.cliqueHeap.Push(cliqueIdx);
+			m_searchFreeSlots.emplace_back(node.slot);
+			m_cliqueCnt++;
+			return true;
+		}
+
+		m_nodeCnt++;
+		// children skip the view of this level or pick one of its available nodes, like EnumCliques
+		const CliqueBits& cliqueBits = m_cliqueBits[node.pafIdx];
+		const int& wordSize = cliqueBits.wordSize;
+		for (int pick = -1; pick != -2; pick = NextBit(SearchBits(node.slot) + node.index * m_searchWordSize, wordSize, pick + 1, -2)) {
+			// a new slot may move the buffers, so the parent is located after it
+			const int slot = NewSearchSlot();
+			int* picks = SearchPicks(slot);
+			uint64_t* bits = SearchBits(slot);
+			const int* parentPicks = SearchPicks(node.slot);
+			const uint64_t* parentBits = SearchBits(node.slot);
+			std::copy(parentPicks, parentPicks + viewSize + 1, picks);
+			picks[node.index] = pick;
+
+			if (node.index < viewSize) {
+				// epipolar constrain
+				for (int view = node.index + 1; view < viewSize; view++) {
+					const uint64_t* prevBits = parentBits + view * m_searchWordSize;
+					uint64_t* viewBits = bits + view * m_searchWordSize;
+					if (pick >= 0) {
+						const uint64_t* epi = cliqueBits.epiBits.data() + cliqueBits.epiOffsets[node.index * viewSize + view] + pick * wordSize;
+						for (int w = 0; w < wordSize; w++)
+							viewBits[w] = prevBits[w] & epi[w];
+					}
+					else
+						std::copy(prevBits, prevBits + wordSize, viewBits);
+				}
+
+				// temporal constrain
+				const uint64_t* prevBits = parentBits + viewSize * m_searchWordSize;
+				uint64_t* personBits = bits + viewSize * m_searchWordSize;
+				if (node.index == viewSize - 1 && pick >= 0) {
+					const uint64_t* temp = cliqueBits.tempBits.data() + pick * wordSize;
+					for (int w = 0; w < wordSize; w++)
+						personBits[w] = prevBits[w] & temp[w];
+				}
+				else
+					std::copy(prevBits, prevBits + wordSize, personBits);
+			}
+			PushSearchNode(node.pafIdx, node.index + 1, slot);
+		}
+		m_searchFreeSlots.emplace_back(node.slot);
+	}
+	return false;
+}
+
+
+void KruskalAssociater::PushClique(SpanContext& span, const int& pafIdx, const Eigen::Ref<const Eigen::VectorXi>& proposal)
 {
 	if (proposal.head(m_cams.size()).maxCoeff() == -1)
 		return;
-	BoneClique clique;
-	clique.pafIdx = pafIdx;
+	const int cliqueIdx = span.cliqueHeap.New(pafIdx);
+	BoneClique clique = span.cliqueHeap.Get(cliqueIdx);
 	clique.proposal = proposal;
 	CalcCliqueScore(clique);
-	cliques.emplace_back(clique);
-	std::push_heap(cliques.begin(), cliques.end());
+	span.cliqueHeap.SetScore(cliqueIdx, clique.score);
+	span.cliqueHeap.Push(cliqueIdx);
+}
+
+
+void KruskalAssociater::TouchPerson(SpanContext& span, const int& pIdx)
+{
+	// a person gets its cache row the first time it is touched in the frame
+	if (pIdx >= span.personSlots.size())
+		span.personSlots.resize(pIdx + 1, -1);
+	int& slot = span.personSlots[pIdx];
+	if (slot == -1) {
+		slot = span.personSlotSize++;
+		if (slot >= span.personVersions.size())
+			span.personVersions.resize(slot + 1, 0);
+	}
+	span.personVersions[slot] = ++span.versionClock;
+}
+
+
+void KruskalAssociater::InitCompatibilityCache()
+{
+	// the candidates of every view and joint are numbered side by side. a span caches a row per person it touched with
+	// a column per candidate of its component, so its caches are bounded by its own persons and candidates. entries
+	// of earlier frames are never hit, the version clock of a span only moves on
+	m_viewCandiOffsets.resize(m_cams.size() + 1);
+	m_viewCandiOffsets[0] = 0;
+	for (int view = 0; view < m_cams.size(); view++)
+		m_viewCandiOffsets[view + 1] = m_viewCandiOffsets[view] + m_jointRayOffsets[view].back();
+	m_candiSize = m_viewCandiOffsets.back();
+}
+
+
+void KruskalAssociater::CalcCandiSlots(const bool& split)
+{
+	// components partition the candidates, a span only checks the candidates of its own component
+	m_candiSlots.resize(m_candiSize);
+	if (!split) {
+		std::iota(m_candiSlots.begin(), m_candiSlots.end(), 0);
+		m_spans.front().candiSize = m_candiSize;
+		return;
+	}
+	for (int candi = 0; candi < m_candiSize; candi++) {
+		const int label = m_componentLabels[GetComponent(candi)];
+		m_candiSlots[candi] = label == -1 ? -1 : m_spans[label].candiSize++;
+	}
 }
 
 
-int KruskalAssociater::CheckJointCompatibility(const int& view, const int& jIdx, const int& candiIdx, const int& pIdx)
+int KruskalAssociater::CheckJointCompatibility(SpanContext& span, const int& view, const int& jIdx, const int& candiIdx, const int& pIdx)
+{
+	const int slot = span.personSlots[pIdx];
+	const int candiSlot = m_candiSlots[m_viewCandiOffsets[view] + m_jointRayOffsets[view][jIdx] + candiIdx];
+	assert(slot != -1 && candiSlot >= 0 && candiSlot < span.candiSize);
+	const size_t idx = size_t(slot) * span.candiSize + candiSlot;
+	if (idx >= span.jointCache.size())
+		span.jointCache.resize(size_t(slot + 1) * span.candiSize, CompatibilityEntry{ { -1, -1 }, 0 });
+
+	CompatibilityEntry& entry = span.jointCache[idx];
+	if (entry.versions[0] == span.personVersions[slot]) {
+		span.jointCacheHitCnt++;
+		return entry.checkCnt;
+	}
+	span.jointCacheMissCnt++;
+	entry.versions[0] = span.personVersions[slot];
+	entry.checkCnt = CalcJointCompatibility(span, view, jIdx, candiIdx, pIdx);
+	return entry.checkCnt;
+}
+
+
+int KruskalAssociater::CalcJointCompatibility(SpanContext& span, const int& view, const int& jIdx, const int& candiIdx, const int& pIdx)
 {
 	const SkelDef& def = GetSkelDef(m_type);
-	const Eigen::MatrixXi& person = m_personsMap.find(pIdx)->second;
+	const PersonStore::Person person = span.persons[pIdx];
 	int checkCnt = 0;
 	
 	// joint conflict 
@@ -294,10 +941,10 @@ int KruskalAssociater::CheckJointCompatibility(const int& view, const int& jIdx,
 	}
 
 	// epi conflict
-	for (int i = 0; i < m_cams.size(); i++) {
-		if (i == view || person(jIdx, i) == -1)
+	for (const int& i : m_viewNeighbors[view]) {
+		if (person(jIdx, i) == -1)
 			continue;
-		if (m_epiEdges[jIdx][view][i](candiIdx, person(jIdx, i)) > 0.f)
+		if (HasEdge(GetEpiEdges(jIdx, view, i), candiIdx, person(jIdx, i)))
 			checkCnt++;
 		else
 			return -1;
@@ -315,7 +962,7 @@ int KruskalAssociater::CheckJointCompatibility(const int& view, const int& jIdx,
 }
 
 
-int KruskalAssociater::CheckPersonCompatibility(const int& masterIdx, const int& slaveIdx, const int& view)
+int KruskalAssociater::CheckPersonCompatibility(SpanContext& span, const int& masterIdx, const int& slaveIdx, const int& view)
 {
 	assert(masterIdx < slaveIdx);
 	// master and slave are tracked different temporal person must conflict
@@ -324,8 +971,8 @@ int KruskalAssociater::CheckPersonCompatibility(const int& masterIdx, const int&
 
 	int checkCnt = 0;
 	const SkelDef& def = GetSkelDef(m_type);
-	const Eigen::MatrixXi& master = m_personsMap.find(masterIdx)->second;
-	const Eigen::MatrixXi& slave = m_personsMap.find(slaveIdx)->second;
+	const PersonStore::Person master = span.persons[masterIdx];
+	const PersonStore::Person slave = span.persons[slaveIdx];
 
 	for (int jIdx = 0; jIdx < def.jointSize; jIdx++)
 		if (master(jIdx, view) != -1 && slave(jIdx, view) != -1 && master(jIdx, view) != slave(jIdx, view))
@@ -335,16 +982,17 @@ int KruskalAssociater::CheckPersonCompatibility(const int& masterIdx, const int&
 	if (masterIdx < m_skels3dPrev.size())
 		for (int jIdx = 0; jIdx < def.jointSize; jIdx++)
 			if (slave(jIdx,view) != -1)
-				if (m_tempEdges[jIdx][view](masterIdx, slave(jIdx, view)) > 0.f)
+				if (HasEdge(m_tempEdges[jIdx][view].Rows(), masterIdx, slave(jIdx, view)))
 					checkCnt++;
 				else
 					return -1;
 
 	for (int pafIdx = 0; pafIdx < def.pafSize; pafIdx++) {
 		const Eigen::MatrixXf& paf = m_detections[view].pafs[pafIdx];
-		for (const auto& candi : std::vector<Eigen::Vector2i>({
+		const Eigen::Vector2i candis[2] = {
 			{master(def.pafDict(0, pafIdx),view), slave(def.pafDict(1, pafIdx),view)},
-			{slave(def.pafDict(0, pafIdx),view), master(def.pafDict(1, pafIdx),view)} }))
+			{slave(def.pafDict(0, pafIdx),view), master(def.pafDict(1, pafIdx),view)} };
+		for (const auto& candi : candis)
 			if (candi.minCoeff() >= 0)
 				if (paf(candi.x(), candi.y()) > 0.f)
 					checkCnt++;
@@ -355,7 +1003,30 @@ int KruskalAssociater::CheckPersonCompatibility(const int& masterIdx, const int&
 }
 
 
-int KruskalAssociater::CheckPersonCompatibility(const int& masterIdx, const int& slaveIdx)
+int KruskalAssociater::CheckPersonCompatibility(SpanContext& span, const int& masterIdx, const int& slaveIdx)
+{
+	assert(masterIdx < slaveIdx);
+	const int masterSlot = span.personSlots[masterIdx];
+	const int slaveSlot = span.personSlots[slaveIdx];
+	if (std::max(masterSlot, slaveSlot) >= span.personCacheStride) {
+		span.personCacheStride = std::max(2 * span.personCacheStride, std::max(masterSlot, slaveSlot) + 1);
+		span.personCache.assign(size_t(span.personCacheStride) * span.personCacheStride, CompatibilityEntry{ { -1, -1 }, 0 });
+	}
+
+	CompatibilityEntry& entry = span.personCache[size_t(masterSlot) * span.personCacheStride + slaveSlot];
+	if (entry.versions[0] == span.personVersions[masterSlot] && entry.versions[1] == span.personVersions[slaveSlot]) {
+		span.personCacheHitCnt++;
+		return entry.checkCnt;
+	}
+	span.personCacheMissCnt++;
+	entry.versions[0] = span.personVersions[masterSlot];
+	entry.versions[1] = span.personVersions[slaveSlot];
+	entry.checkCnt = CalcPersonCompatibility(span, masterIdx, slaveIdx);
+	return entry.checkCnt;
+}
+
+
+int KruskalAssociater::CalcPersonCompatibility(SpanContext& span, const int& masterIdx, const int& slaveIdx)
 {
 	assert(masterIdx < slaveIdx);
 	if (slaveIdx < m_skels3dPrev.size())
@@ -363,11 +1034,11 @@ int KruskalAssociater::CheckPersonCompatibility(const int& masterIdx, const int&
 
 	int checkCnt = 0;
 	const SkelDef& def = GetSkelDef(m_type);
-	const auto& master = m_personsMap.find(masterIdx)->second;
-	const auto& slave = m_personsMap.find(slaveIdx)->second;
+	const PersonStore::Person master = span.persons[masterIdx];
+	const PersonStore::Person slave = span.persons[slaveIdx];
 
 	for (int view = 0; view < m_cams.size(); view++) {
-		int _checkCnt = CheckPersonCompatibility(masterIdx, slaveIdx, view);
+		int _checkCnt = CheckPersonCompatibility(span, masterIdx, slaveIdx, view);
 		if (_checkCnt == -1)
 			return -1;
 		else
@@ -378,10 +1049,10 @@ int KruskalAssociater::CheckPersonCompatibility(const int& masterIdx, const int&
 		for (int viewA = 0; viewA < m_cams.size() - 1; viewA++) {
 			const int candiAIdx = master(jIdx, viewA);
 			if (candiAIdx != -1) {
-				for (int viewB = viewA + 1; viewB < m_cams.size(); viewB++) {
+				for (const int& viewB : m_viewSuccessors[viewA]) {
 					const int candiBIdx = slave(jIdx, viewB);
 					if (candiBIdx != -1)
-						if (m_epiEdges[jIdx][viewA][viewB](candiAIdx, candiBIdx) > 0.f)
+						if (HasEdge(m_epiEdges[jIdx][viewA][viewB].Rows(), candiAIdx, candiBIdx))
 							checkCnt++;
 						else
 							return -1;
@@ -393,12 +1064,11 @@ int KruskalAssociater::CheckPersonCompatibility(const int& masterIdx, const int&
 }
 
 
-void KruskalAssociater::MergePerson(const int& masterIdx, const int& slaveIdx)
+void KruskalAssociater::MergePerson(SpanContext& span, const int& masterIdx, const int& slaveIdx)
 {
 	assert(masterIdx < slaveIdx);
-	Eigen::MatrixXi& master = m_personsMap.find(masterIdx)->second;
-	auto slaveIter = m_personsMap.find(slaveIdx);
-	const Eigen::MatrixXi& slave = slaveIter->second;
+	PersonStore::Person master = span.persons[masterIdx];
+	const PersonStore::Person slave = span.persons[slaveIdx];
 	const SkelDef& def = GetSkelDef(m_type);
 	for (int view = 0; view < m_cams.size(); view++)
 		for (int jIdx = 0; jIdx < def.jointSize; jIdx++)
@@ -406,14 +1076,15 @@ void KruskalAssociater::MergePerson(const int& masterIdx, const int& slaveIdx)
 				master(jIdx,view) = slave(jIdx, view);
 				m_assignMap[view][jIdx][slave(jIdx, view)] = masterIdx;
 			}
-	m_personsMap.erase(slaveIter);
+	TouchPerson(span, masterIdx);
+	span.persons.Erase(slaveIdx);
 }
 
 
-void KruskalAssociater::Clique2Voting(const BoneClique& clique, Voting& voting)
+void KruskalAssociater::Clique2Voting(SpanContext& span, const BoneClique& clique, Voting& voting)
 {
 	voting.vote.clear();
-	if (m_personsMap.empty())
+	if (span.persons.Empty())
 		return;
 	const SkelDef& def = GetSkelDef(m_type);
 	for (int view = 0; view < m_cams.size(); view++) {
@@ -423,10 +1094,7 @@ void KruskalAssociater::Clique2Voting(const BoneClique& clique, Voting& voting)
 			for (int i = 0; i < 2; i++) {
 				const int assigned = m_assignMap[view][def.pafDict(i, clique.pafIdx)][node[i]];
 				if (assigned != -1) {
-					auto iter = voting.vote.find(assigned);
-					if (iter == voting.vote.end())
-						iter = voting.vote.insert(std::make_pair(assigned, Eigen::Vector2i::Zero())).first;
-					iter->second[i]++;
+					voting.Vote(assigned)[i]++;
 				}
 			}
 		}
@@ -434,6 +1102,16 @@ void KruskalAssociater::Clique2Voting(const BoneClique& clique, Voting& voting)
 }
 
 
+Eigen::Vector2i& KruskalAssociater::Voting::Vote(const int& pIdx)
+{
+	auto iter = std::lower_bound(vote.begin(), vote.end(), pIdx, [](const std::pair<int, Eigen::Vector2i>& v, const int& pIdx) {
+		return v.first < pIdx; });
+	if (iter == vote.end() || iter->first != pIdx)
+		iter = vote.insert(iter, std::make_pair(pIdx, Eigen::Vector2i::Zero()));
+	return iter->second;
+}
+
+
 void KruskalAssociater::Voting::Parse()
 {
 	fstCnt.setZero();
@@ -441,10 +1119,10 @@ void KruskalAssociater::Voting::Parse()
 	if (vote.empty())
 		return;
 
-	std::map<int, Eigen::Vector2i> _vote = vote;
+	parsed = vote;
 	for (int i = 0; i < 2; i++) {
 		for (int index = 0; index < 2; index++) {
-			auto iter = std::max_element(_vote.begin(), _vote.end(), [&index](
+			auto iter = std::max_element(parsed.begin(), parsed.end(), [&index](
 				const std::pair<int, Eigen::Vector2i>& l, const std::pair<int, Eigen::Vector2i>& r) {
 				return (l.second[index] < r.second[index]);
 			});
@@ -457,24 +1135,29 @@ void KruskalAssociater::Voting::Parse()
 }
 
 
-void KruskalAssociater::AssignTopClique(std::vector<BoneClique>& cliques)
+void KruskalAssociater::AssignTopClique(SpanContext& span)
 {
 	const SkelDef& def = GetSkelDef(m_type);
-	const BoneClique clique = *cliques.begin();
-	std::pop_heap(cliques.begin(), cliques.end());
-	cliques.pop_back();
+
+	// the top clique is copied out, its slot is reused by the cliques pushed below
+	const int cliqueIdx = span.cliqueHeap.Pop();
+	const float score = span.cliqueHeap.Get(cliqueIdx).score;
+	span.topProposal = span.cliqueHeap.Get(cliqueIdx).proposal;
+	const BoneClique clique(span.cliqueHeap.Get(cliqueIdx).pafIdx, Eigen::Map<Eigen::VectorXi>(span.topProposal.data(), span.topProposal.size()));
+	span.cliqueHeap.Free(cliqueIdx);
 
 	const auto& nodes = m_boneNodes[clique.pafIdx];
 	const auto& jIdxPair = def.pafDict.col(clique.pafIdx);
 	if (clique.proposal[m_cams.size()] != -1) {
 		const int personIdx = clique.proposal[m_cams.size()];
+		assert(span.persons.Contains(personIdx));
 		const int checkCnt = [&]() {
 			int cnt = 0;
 			for (int view = 0; view < m_cams.size(); view++) {
 				const int index = clique.proposal[view];
 				if (index != -1) {
 					for (int i = 0; i < 2; i++) {
-						const int _cnt = CheckJointCompatibility(view, jIdxPair[i], nodes[view][index][i], personIdx);
+						const int _cnt = CheckJointCompatibility(span, view, jIdxPair[i], nodes[view][index][i], personIdx);
 						if (_cnt == -1)
 							return -1;
 						else
@@ -486,8 +1169,8 @@ void KruskalAssociater::AssignTopClique(std::vector<BoneClique>& cliques)
 		}();
 
 		if (checkCnt != -1) {
-			Eigen::MatrixXi& person = m_personsMap.find(personIdx)->second;
-			Eigen::VectorXi _proposal = Eigen::VectorXi::Constant(m_cams.size() + 1, -1);
+			PersonStore::Person person = span.persons[personIdx];
+			Eigen::Map<Eigen::VectorXi> _proposal = NewProposal(span);
 			for (int view = 0; view < m_cams.size(); view++) {
 				if (clique.proposal[view] != -1) {
 					const Eigen::Vector2i& node = nodes[view][clique.proposal[view]];
@@ -498,22 +1181,24 @@ void KruskalAssociater::AssignTopClique(std::vector<BoneClique>& cliques)
 							person(jIdxPair[i], view) = node[i];
 							m_assignMap[view][jIdxPair[i]][node[i]] = personIdx;
 						}
+						TouchPerson(span, personIdx);
 					}
 					else
 						_proposal[view] = clique.proposal[view];
 				}
 			}
-			PushClique(clique.pafIdx, _proposal, cliques);
+			PushClique(span, clique.pafIdx, _proposal);
 		}
 		else {
-			Eigen::VectorXi _proposal = clique.proposal;
+			Eigen::Map<Eigen::VectorXi> _proposal = NewProposal(span);
+			_proposal = clique.proposal;
 			_proposal[m_cams.size()] = -1;
-			PushClique(clique.pafIdx, _proposal, cliques);
+			PushClique(span, clique.pafIdx, _proposal);
 		}
 	}
 	else {
-		Voting voting;
-		Clique2Voting(clique, voting);
+		Voting& voting = span.voting;
+		Clique2Voting(span, clique, voting);
 		voting.Parse();
 
 		// 1. A & B not assigned yet: 
@@ -525,12 +1210,13 @@ void KruskalAssociater::AssignTopClique(std::vector<BoneClique>& cliques)
 				int view;
 				clique.proposal.maxCoeff(&view);
 				const Eigen::Vector2i& node = nodes[view][clique.proposal[view]];
-				std::vector<std::pair<int, int>> personCandidates;
-				for (const auto& person : m_personsMap) {
+				std::vector<std::pair<int, int>>& personCandidates = span.personCandidates;
+				personCandidates.clear();
+				for (int pIdx = span.persons.Begin(); pIdx != span.persons.End(); pIdx = span.persons.Next(pIdx)) {
 					const int checkCnt = [&]() {
 						int cnt = 0;
 						for (int i = 0; i < 2; i++) {
-							const int _cnt = CheckJointCompatibility(view, jIdxPair[i], node[i], person.first);
+							const int _cnt = CheckJointCompatibility(span, view, jIdxPair[i], node[i], pIdx);
 							if (_cnt == -1)
 								return -1;
 							cnt += _cnt;
@@ -538,24 +1224,29 @@ void KruskalAssociater::AssignTopClique(std::vector<BoneClique>& cliques)
 						return cnt;
 					}();
 					if (checkCnt >= m_minCheckCnt)
-						personCandidates.emplace_back(std::make_pair(checkCnt, person.first));
+						personCandidates.emplace_back(std::make_pair(checkCnt, pIdx));
 				}
 
 				if (personCandidates.size() == 0)
 					return true;
 				const int personIdx = std::max_element(personCandidates.begin(), personCandidates.end())->second;
-				Eigen::MatrixXi& person = m_personsMap.find(personIdx)->second;
+				PersonStore::Person person = span.persons[personIdx];
 				for (int i = 0; i < 2; i++) {
 					person(jIdxPair[i], view) = node[i];
 					m_assignMap[view][jIdxPair[i]][node[i]] = personIdx;
 				}
+				TouchPerson(span, personIdx);
 				return false;
 			}();
 
 			// create new person
 			if (allocFlag) {
-				Eigen::MatrixXi person = Eigen::MatrixXi::Constant(def.jointSize, m_cams.size(), -1);
-				const int personIdx = m_personsMap.empty() ? 0 : m_personsMap.rbegin()->first + 1;
+				const int personIdx = std::max(span.persons.End(), int(m_skels3dPrev.size()));
+				PersonStore::Person person = span.persons.Insert(personIdx);
+				TouchPerson(span, personIdx);
+				if (personIdx >= span.birthScores.size())
+					span.birthScores.resize(personIdx + 1);
+				span.birthScores[personIdx] = score;
 				for (int view = 0; view < m_cams.size(); view++) {
 					if (clique.proposal[view] >= 0) {
 						const Eigen::Vector2i& node = nodes[view][clique.proposal[view]];
@@ -565,7 +1256,6 @@ void KruskalAssociater::AssignTopClique(std::vector<BoneClique>& cliques)
 						}
 					}
 				}
-				m_personsMap.insert(std::make_pair(personIdx, person));
 			}
 		}
 
@@ -575,9 +1265,9 @@ void KruskalAssociater::AssignTopClique(std::vector<BoneClique>& cliques)
 			const int validIdx = voting.fstCnt[0] > 0 ? 0 : 1;
 			const int masterIdx = voting.fst[validIdx];
 			const int unasgnJIdx = jIdxPair[1 - validIdx];
-			Eigen::MatrixXi& person = m_personsMap.find(masterIdx)->second;
+			PersonStore::Person person = span.persons[masterIdx];
 
-			Eigen::VectorXi _proposal = Eigen::VectorXi::Constant(m_cams.size() + 1, -1);
+			Eigen::Map<Eigen::VectorXi> _proposal = NewProposal(span);
 			for (int view = 0; view < m_cams.size(); view++) {
 				if (clique.proposal[view] >= 0) {
 					const Eigen::Vector2i& node = nodes[view][clique.proposal[view]];
@@ -586,9 +1276,10 @@ void KruskalAssociater::AssignTopClique(std::vector<BoneClique>& cliques)
 					int& unassigned = m_assignMap[view][jIdxPair[1 - validIdx]][node[1 - validIdx]];
 
 					if (assigned == masterIdx) {
-						if (person(unasgnJIdx, view) == -1 && CheckJointCompatibility(view, unasgnJIdx, unasgnJCandiIdx, masterIdx) >= 0) {
+						if (person(unasgnJIdx, view) == -1 && CheckJointCompatibility(span, view, unasgnJIdx, unasgnJCandiIdx, masterIdx) >= 0) {
 							person(unasgnJIdx, view) = unasgnJCandiIdx;
 							unassigned = masterIdx;
+							TouchPerson(span, masterIdx);
 						}
 						else
 							continue;				// discard this view's propose
@@ -596,12 +1287,13 @@ void KruskalAssociater::AssignTopClique(std::vector<BoneClique>& cliques)
 					else if (assigned == -1 && voting.fstCnt[validIdx] >= 2 && voting.secCnt[validIdx] == 0
 						&& (person(jIdxPair.x(), view) == -1 || person(jIdxPair.x(), view) == node.x())
 						&& (person(jIdxPair.y(), view) == -1 || person(jIdxPair.y(), view) == node.y()))
-						if (CheckJointCompatibility(view, jIdxPair.x(), node.x(), masterIdx) >= 0
-							&& CheckJointCompatibility(view, jIdxPair.y(), node.y(), masterIdx) >= 0) {
+						if (CheckJointCompatibility(span, view, jIdxPair.x(), node.x(), masterIdx) >= 0
+							&& CheckJointCompatibility(span, view, jIdxPair.y(), node.y(), masterIdx) >= 0) {
 							for (int i = 0; i < 2; i++) {
 								person(jIdxPair[i], view) = node[i];
 								m_assignMap[view][jIdxPair[i]][node[i]] = masterIdx;
 							}
+							TouchPerson(span, masterIdx);
 						}
 						else
 							_proposal[view] = clique.proposal[view];
@@ -610,22 +1302,22 @@ void KruskalAssociater::AssignTopClique(std::vector<BoneClique>& cliques)
 				}
 			}
 			if (_proposal != clique.proposal)
-				PushClique(clique.pafIdx, _proposal, cliques);
+				PushClique(span, clique.pafIdx, _proposal);
 		}
 
 		// 4. A & B already assigned to same person (circular/redundant PAF)
 		else if (voting.fst.x() == voting.fst.y()) {
 			const int masterIdx = voting.fst.x();
-			Eigen::MatrixXi& person = m_personsMap.find(masterIdx)->second;
-			Eigen::VectorXi _proposal = Eigen::VectorXi::Constant(m_cams.size() + 1, -1);
+			PersonStore::Person person = span.persons[masterIdx];
+			Eigen::Map<Eigen::VectorXi> _proposal = NewProposal(span);
 			for (int view = 0; view < m_cams.size(); view++) {
 				if (clique.proposal[view] >= 0) {
 					const Eigen::Vector2i& node = nodes[view][clique.proposal[view]];
 					const Eigen::Vector2i assignIdx(m_assignMap[view][jIdxPair.x()][node.x()], m_assignMap[view][jIdxPair.y()][node.y()]);
 					if (assignIdx.x() == masterIdx && assignIdx.y() == masterIdx) 
 						continue;
-					else if (CheckJointCompatibility(view, jIdxPair.x(), node.x(), masterIdx) == -1
-						|| CheckJointCompatibility(view, jIdxPair.y(), node.y(), masterIdx) == -1)
+					else if (CheckJointCompatibility(span, view, jIdxPair.x(), node.x(), masterIdx) == -1
+						|| CheckJointCompatibility(span, view, jIdxPair.y(), node.y(), masterIdx) == -1)
 						_proposal[view] = clique.proposal[view];
 
 					else if ((assignIdx.x() == masterIdx && assignIdx.y() == -1)
@@ -637,6 +1329,7 @@ void KruskalAssociater::AssignTopClique(std::vector<BoneClique>& cliques)
 						if (person(unasgnJIdx, view) == -1 || person(unasgnJIdx, view) == unasgnJCandiIdx) {
 							person(unasgnJIdx, view) = unasgnJCandiIdx;
 							unassigned = masterIdx;
+							TouchPerson(span, masterIdx);
 						}
 						else
 							_proposal[view] = clique.proposal[view];
@@ -648,12 +1341,13 @@ void KruskalAssociater::AssignTopClique(std::vector<BoneClique>& cliques)
 							person(jIdxPair[i], view) = node[i];
 							m_assignMap[view][jIdxPair[i]][node[i]] = masterIdx;
 						}
+						TouchPerson(span, masterIdx);
 					}
 					else
 						_proposal[view] = clique.proposal[view];
 				}
 				if (_proposal != clique.proposal)
-					PushClique(clique.pafIdx, _proposal, cliques);
+					PushClique(span, clique.pafIdx, _proposal);
 			}
 		}
 
@@ -665,13 +1359,13 @@ void KruskalAssociater::AssignTopClique(std::vector<BoneClique>& cliques)
 					// try to merge master and slave
 					const int masterIdx = std::min(voting.fst[index], voting.sec[index]);
 					const int slaveIdx = std::max(voting.fst[index], voting.sec[index]);
-					if (CheckPersonCompatibility(masterIdx, slaveIdx) >= 0) {
-						MergePerson(masterIdx, slaveIdx);
-						Clique2Voting(clique, voting);
+					if (CheckPersonCompatibility(span, masterIdx, slaveIdx) >= 0) {
+						MergePerson(span, masterIdx, slaveIdx);
+						Clique2Voting(span, clique, voting);
 						voting.Parse();
 					}
 					else {
-						voting.vote.find(voting.fst[index])->second[index] = voting.vote.find(voting.sec[index])->second[index] = 0;
+						voting.Vote(voting.fst[index])[index] = voting.Vote(voting.sec[index])[index] = 0;
 						auto iter = std::max_element(voting.vote.begin(), voting.vote.end(), [&index](
 							const std::pair<int, Eigen::Vector2i>& l, const std::pair<int, Eigen::Vector2i>& r) {
 							return(l.second[index] < r.second[index]);
@@ -684,18 +1378,18 @@ void KruskalAssociater::AssignTopClique(std::vector<BoneClique>& cliques)
 
 			// try to cluster by shared bone
 			if (voting.fst.x() != voting.fst.y()) {
-				Eigen::VectorXi conflict(m_cams.size());
+				Eigen::VectorXi& conflict = span.conflict;
 				const int masterIdx = voting.fst.minCoeff();
 				const int slaveIdx = voting.fst.maxCoeff();
 				for (int view = 0; view < m_cams.size(); view++)
-					conflict[view] = CheckPersonCompatibility(masterIdx, slaveIdx, view) == -1 ? 1 : 0;
+					conflict[view] = CheckPersonCompatibility(span, masterIdx, slaveIdx, view) == -1 ? 1 : 0;
 
 				if (conflict.sum() == 0) {
-					MergePerson(masterIdx, slaveIdx);
+					MergePerson(span, masterIdx, slaveIdx);
 
 					// proposal unused paf
-					Eigen::VectorXi _proposal = Eigen::VectorXi::Constant(m_cams.size() + 1, -1);
-					const Eigen::MatrixXi& master = m_personsMap.find(masterIdx)->second;
+					Eigen::Map<Eigen::VectorXi> _proposal = NewProposal(span);
+					const PersonStore::Person master = span.persons[masterIdx];
 					for (int view = 0; view < m_cams.size(); view++) {
 						if (clique.proposal[view] >= 0) {
 							const Eigen::Vector2i& node = nodes[view][clique.proposal[view]];
@@ -703,22 +1397,23 @@ void KruskalAssociater::AssignTopClique(std::vector<BoneClique>& cliques)
 								_proposal[view] = clique.proposal[view];
 						}
 					}
-					PushClique(clique.pafIdx, _proposal, cliques);
+					PushClique(span, clique.pafIdx, _proposal);
 				}
 				else {
-					Eigen::MatrixX2i _proposalPair = Eigen::MatrixX2i::Constant(m_cams.size() + 1, 2, -1);
+					Eigen::MatrixX2i& _proposalPair = span.proposalPair;
+					_proposalPair.setConstant(-1);
 					for (int i = 0; i < conflict.size(); i++)
 						_proposalPair(i, conflict[i]) = clique.proposal[i];
 
 					if (_proposalPair.col(0).minCoeff() >= 0 && _proposalPair.col(1).minCoeff() >= 0) {
-						PushClique(clique.pafIdx, _proposalPair.col(0), cliques);
-						PushClique(clique.pafIdx, _proposalPair.col(1), cliques);
+						PushClique(span, clique.pafIdx, _proposalPair.col(0));
+						PushClique(span, clique.pafIdx, _proposalPair.col(1));
 					}
 					else if ((clique.proposal.array() >= 0).count() > 1) {
 						for (int i = 0; i < conflict.size(); i++) {
-							Eigen::VectorXi _proposal = Eigen::VectorXi::Constant(m_cams.size() + 1, -1);
+							Eigen::Map<Eigen::VectorXi> _proposal = NewProposal(span);
 							_proposal[i] = clique.proposal[i];
-							PushClique(clique.pafIdx, _proposal, cliques);
+							PushClique(span, clique.pafIdx, _proposal);
 						}
 					}
 				}
@@ -728,14 +1423,12 @@ void KruskalAssociater::AssignTopClique(std::vector<BoneClique>& cliques)
 }
 
 
-void KruskalAssociater::DismemberPersons(std::vector<BoneClique>& cliques)
+void KruskalAssociater::DismemberPersons(SpanContext& span)
 {
 	const SkelDef& def = GetSkelDef(m_type);
-	for (auto personIter = std::next(m_personsMap.begin(), m_skels3dPrev.size()); personIter != m_personsMap.end(); ) {
-		const Eigen::MatrixXi& person = personIter->second;
-		if ((person.array() >= 0).count() >= m_minAsgnCnt)
-			personIter++;
-		else {
+	for (int pIdx = span.persons.Next(int(m_skels3dPrev.size()) - 1); pIdx != span.persons.End(); pIdx = span.persons.Next(pIdx)) {
+		const PersonStore::Person person = span.persons[pIdx];
+		if ((person.array() >= 0).count() < m_minAsgnCnt) {
 			for (int view = 0; view < m_cams.size(); view++) {
 				for (int pafIdx = 0; pafIdx < def.pafSize; pafIdx++) {
 					const auto jIdxPair = def.pafDict.col(pafIdx);
@@ -745,9 +1438,9 @@ void KruskalAssociater::DismemberPersons(std::vector<BoneClique>& cliques)
 					const std::vector<Eigen::Vector2i>& nodes = m_boneNodes[pafIdx][view];
 					for (int bone = 0; bone < nodes.size(); bone++)
 						if (node == nodes[bone]) {
-							Eigen::VectorXi proposal = Eigen::VectorXi::Constant(m_cams.size() + 1, -1);
+							Eigen::Map<Eigen::VectorXi> proposal = NewProposal(span);
 							proposal[view] = bone;
-							PushClique(pafIdx, proposal, cliques);
+							PushClique(span, pafIdx, proposal);
 							break;
 						}
 				}
@@ -758,7 +1451,7 @@ void KruskalAssociater::DismemberPersons(std::vector<BoneClique>& cliques)
 				for (int jIdx = 0; jIdx < def.jointSize; jIdx++)
 					if (person(jIdx, view) != -1)
 						m_assignMap[view][jIdx][person(jIdx, view)] = -1;
-			personIter = m_personsMap.erase(personIter);
+			span.persons.Erase(pIdx);
 		}
 	}
 }
@@ -766,11 +1459,81 @@ void KruskalAssociater::DismemberPersons(std::vector<BoneClique>& cliques)
 
 void KruskalAssociater::SpanTree()
 {
-	Initialize();
-	std::vector<BoneClique> cliques;
-	EnumCliques(cliques);
-	while (!cliques.empty())
-		AssignTopClique(cliques);
+	InitCompatibilityCache();
+	const bool budgeted = m_cliqueBudget > 0 || m_cliqueTimeBudget > 0.f;
+	const bool split = m_splitComponents && !budgeted && m_minCheckCnt >= 1;
+	m_spanSize = 0;
+	if (split)
+		CalcComponents();
+	else
+		NewSpan();
+
+	if (!budgeted) {
+		EnumCliques(split);
+		CalcCandiSlots(split);
+		for (int pIdx = 0; pIdx < m_skels3dPrev.size(); pIdx++) {
+			const int label = split ? m_componentLabels[GetComponent(m_candiSize + pIdx)] : 0;
+			if (label != -1) {
+				m_spans[label].persons.Insert(pIdx) = m_persons[pIdx];
+				TouchPerson(m_spans[label], pIdx);
+			}
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+#pragma omp parallel for schedule(dynamic) if (m_spanSize > 1)
+		for (int label = 0; label < m_spanSize; label++) {
+			SpanContext& span = m_spans[label];
+			for (; !span.cliqueHeap.Empty(); span.popCnt++)
+				AssignTopClique(span);
+		}
+		m_popTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+	else {
+		// cliques are generated best first, only while one of them may beat the top of the heap. once the budget is
+		// spent the remaining, lower scored cliques are never generated
+		CalcCandiSlots(false);
+		SpanContext& span = m_spans.front();
+		for (int pIdx = 0; pIdx < m_skels3dPrev.size(); pIdx++) {
+			span.persons.Insert(pIdx) = m_persons[pIdx];
+			TouchPerson(span, pIdx);
+		}
+		m_searchStart = std::chrono::steady_clock::now();
+		m_cliqueCnt = 0;
+		m_nodeCnt = 0;
+		m_budgetHit = false;
+		InitCliqueSearch();
+		while (true) {
+			if (SearchClique(span, span.cliqueHeap.Empty() ? -FLT_MAX : span.cliqueHeap.GetTopScore()))
+				continue;
+			if (span.cliqueHeap.Empty())
+				break;
+			AssignTopClique(span);
+			span.popCnt++;
+		}
+		m_popTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_searchStart).count();
+		m_budgetFrameCnt++;
+		m_budgetHitCnt += m_budgetHit ? 1 : 0;
+	}
+
+	m_popCnt = 0;
+	for (int label = 0; label < m_spanSize; label++) {
+		const SpanContext& span = m_spans[label];
+		m_popCnt += span.popCnt;
+		m_jointCacheHitCnt += span.jointCacheHitCnt;
+		m_jointCacheMissCnt += span.jointCacheMissCnt;
+		m_personCacheHitCnt += span.personCacheHitCnt;
+		m_personCacheMissCnt += span.personCacheMissCnt;
+	}
+
+	// a single span already holds every person under its final id
+	if (split)
+		MergeSpans();
+	else
+		m_persons = m_spans.front().persons;
+
+	// spans only a busier frame needed are released with their heaps and caches, so a single crowded frame does not
+	// pin its memory for the rest of the run. a steady component count keeps its spans and does not allocate
+	m_spans.erase(m_spans.begin() + m_spanSize, m_spans.end());
 }
 
 
@@ -780,9 +1543,13 @@ void KruskalAssociater::Associate()
 	CalcPafEdges();
 	CalcEpiEdges();
 	CalcTempEdges();
+	Initialize();
+	if (m_fastPath)
+		ClaimTracked();
 	CalcBoneNodes();
 	CalcBoneEpiEdges();
 	CalcBoneTempEdges();
+	CalcCliqueBits();
 	SpanTree();
 	CalcSkels2d();
 }
@@ -1,4 +1,8 @@
 #pragma once
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <tuple>
 #include "associater.h"
 
 
@@ -17,28 +21,153 @@ public:
 	void SetMinCheckCnt(const int& _minCheckCnt) { m_minCheckCnt = _minCheckCnt; }
 	void SetNodeMultiplex(const bool& _nodeMultiplex) { m_nodeMultiplex = _nodeMultiplex; }
 
+	// people sharing no edge are assigned apart in parallel. needs a min check count of 1 or more and no clique budget,
+	// the whole frame is a single component otherwise
+	void SetSplitComponents(const bool& _splitComponents) { m_splitComponents = _splitComponents; }
+	int GetComponentCnt() const { return m_spanSize; }
+
+	// with a budget of cliques or seconds per frame cliques are searched best first instead of all enumerated, 0 for none.
+	// a clique budget also bounds the partial proposals expanded on the way, most of which complete no clique, to the
+	// node budget or by default to the clique budget times the views + 1 expansions of a clique
+	void SetCliqueBudget(const int& _cliqueBudget) { m_cliqueBudget = _cliqueBudget; }
+	void SetCliqueTimeBudget(const float& _cliqueTimeBudget) { m_cliqueTimeBudget = _cliqueTimeBudget; }
+	void SetNodeBudget(const long long& _nodeBudget) { m_nodeBudget = _nodeBudget; }
+	int GetCliqueCnt() const { return m_cliqueCnt; }
+	long long GetNodeCnt() const { return m_nodeCnt; }		// proposals expanded by the search of the last frame
+	int GetBudgetFrameCnt() const { return m_budgetFrameCnt; }
+	int GetBudgetHitCnt() const { return m_budgetHitCnt; }
+	int GetPopCnt() const { return m_popCnt; }
+	double GetPopTime() const { return m_popTime; }		// seconds popping and assigning cliques, with the search if budgeted
+
+	// on the temporal fast path a tracked person claims the candidates it is the only temporal edge of, where it has
+	// no other. a person claiming at least the min claim ratio of the joints it has temporal edges in is assigned its
+	// claims up front, the clique search then sees only the bones not fully claimed
+	void SetTemporalFastPath(const bool& _fastPath) { m_fastPath = _fastPath; }
+	void SetMinClaimRatio(const float& _minClaimRatio) { m_minClaimRatio = _minClaimRatio; }
+	float GetFastPathRatio() const { return m_fastPathRatio; }	// fast pathed persons of the tracked in the last frame
+
+	// compatibility checks are cached until a person involved changes, hits and misses since construction
+	long long GetJointCacheHitCnt() const { return m_jointCacheHitCnt; }
+	long long GetJointCacheMissCnt() const { return m_jointCacheMissCnt; }
+	long long GetPersonCacheHitCnt() const { return m_personCacheHitCnt; }
+	long long GetPersonCacheMissCnt() const { return m_personCacheMissCnt; }
+
 private:
+	// a clique seen through its proposal, which lives in the clique heap or in a scratch buffer
 	struct BoneClique
 	{
 		float score;
 		int pafIdx;
-		Eigen::VectorXi proposal;
-		bool operator < (const BoneClique &b) const { return score < b.score; }
+		Eigen::Map<Eigen::VectorXi> proposal;
+		BoneClique(const int& _pafIdx, const Eigen::Map<Eigen::VectorXi>& _proposal) : pafIdx(_pafIdx), proposal(_proposal) {}
+	};
+
+	// cliques pooled at a fixed stride of views + 1 proposal slots and addressed by index, so the heap only moves
+	// indices and popped cliques are reused by the next pushes
+	class CliqueHeap
+	{
+	public:
+		void Reset(const int& proposalSize);
+		int New(const int& pafIdx);
+		void Free(const int& idx) { m_freeIdxs.emplace_back(idx); }
+		BoneClique Get(const int& idx);
+		void SetScore(const int& idx, const float& score) { m_scores[idx] = score; }
+		bool Empty() const { return m_heap.empty(); }
+		int GetSize() const { return int(m_heap.size()); }
+		float GetTopScore() const { return m_heap.front().score; }
+		void Append(const int& idx) { m_heap.emplace_back(Entry{ m_scores[idx], idx }); }
+		void MakeHeap() { std::make_heap(m_heap.begin(), m_heap.end()); }
+		void Push(const int& idx);
+		int Pop();
+
+	private:
+		// the score is kept next to the index, so sifting never touches the pool
+		struct Entry
+		{
+			float score;
+			int idx;
+			bool operator < (const Entry& e) const { return score < e.score; }
+		};
+
+		int m_proposalSize = 0;
+		int m_size = 0;
+		std::vector<int> m_proposals, m_pafIdxs, m_freeIdxs;
+		std::vector<float> m_scores;
+		std::vector<Entry> m_heap;
+	};
+
+	// bone adjacency of every view pair and of the last view to the persons, as rows of bitsets
+	struct CliqueBits
+	{
+		int wordSize;
+		std::vector<int> epiOffsets;			// epiOffsets[viewA * viewSize + viewB], viewA < viewB
+		std::vector<uint64_t> epiBits, tempBits;
+		float maxEpi, maxTemp;
+	};
+
+	// partial proposal of the best-first search, the views before index are decided
+	struct SearchNode
+	{
+		float bound;
+		int pafIdx, index, slot;
+		bool operator < (const SearchNode& n) const { return bound < n.bound; }
+	};
+
+	// a cached check stays valid while the versions of its persons are unchanged
+	struct CompatibilityEntry
+	{
+		long long versions[2];
+		int checkCnt;
 	};
 
 	struct Voting
 	{
 		Eigen::Vector2i fst, sec, fstCnt, secCnt;
-		std::map<int, Eigen::Vector2i> vote;
+		std::vector<std::pair<int, Eigen::Vector2i>> vote, parsed;	// sorted by person id, a few persons at most
+		Eigen::Vector2i& Vote(const int& pIdx);
 		void Parse();
 	};
 
+	// assignment state of a connected component. tracked persons keep their ids, new persons get ids from the
+	// tracked size on, so a component is assigned exactly as the whole frame would be
+	struct SpanContext
+	{
+		CliqueHeap cliqueHeap;
+		PersonStore persons;
+		std::vector<float> birthScores;			// birthScores[pIdx], score of the clique creating the person
+		Eigen::VectorXi topProposal, proposal, conflict;
+		Eigen::MatrixX2i proposalPair;
+		Voting voting;
+		std::vector<std::pair<int, int>> personCandidates;	// (checkCnt, pIdx) of a single view clique
+		std::vector<int> personSlots;			// personSlots[pIdx], row of the person in the caches or -1
+		int personSlotSize = 0;
+		int candiSize = 0;						// candidates of the span, the columns of the joint cache
+		std::vector<long long> personVersions;	// personVersions[slot], renewed whenever the person changes
+		long long versionClock = 0;
+		std::vector<CompatibilityEntry> jointCache;	// jointCache[slot * candiSize + candiSlot]
+		int personCacheStride = 0;
+		std::vector<CompatibilityEntry> personCache;	// personCache[masterSlot * stride + slaveSlot]
+		long long jointCacheHitCnt = 0, jointCacheMissCnt = 0;
+		long long personCacheHitCnt = 0, personCacheMissCnt = 0;
+		int popCnt = 0;
+	};
+
 	std::vector<std::vector<int>> m_joint2paf;
 	Eigen::VectorXi m_pafHier;
 	int m_pafHierSize;
 	std::vector<std::vector<std::vector<Eigen::Vector2i>>> m_boneNodes;		// m_nodes[pafIdx][camIdx][boneIdx] = (jaCandiIdx, jbCandiIdx)
-	std::vector<std::vector<std::vector<Eigen::MatrixXf>>> m_boneEpiEdges;	// m_boneEpiEdges[pafIdx][viewA][viewB](boneAIdx, boneBIdx)
-	std::vector<std::vector<Eigen::MatrixXf>> m_boneTempEdges;				// m_boneTempEdge[pafIdx][view](pIdx, boneIdx)
+	std::vector<std::vector<std::vector<EdgeGraph>>> m_boneEpiEdges;		// m_boneEpiEdges[pafIdx][viewA][viewB](boneAIdx, boneBIdx), viewA < viewB
+	std::vector<std::vector<EdgeGraph>> m_boneTempEdges;					// m_boneTempEdge[pafIdx][view](pIdx, boneIdx)
+	std::vector<std::vector<int>> m_pafProposals;							// m_pafProposals[pafIdx], enumerated proposals back to back
+	std::vector<std::vector<float>> m_pafScores;							// m_pafScores[pafIdx][cliqueIdx]
+	std::vector<CliqueBits> m_cliqueBits;									// m_cliqueBits[pafIdx]
+
+	std::vector<SearchNode> m_searchHeap;
+	std::vector<int> m_searchPicks, m_searchFreeSlots;						// picks and available nodes of a node are stored in its slot
+	std::vector<uint64_t> m_searchBits;
+	int m_searchSlotSize = 0;
+	int m_searchWordSize = 0;
+	std::chrono::steady_clock::time_point m_searchStart;
 	
 	float m_wEpi = 1.f;
 	float m_wTemp = 3.f;
@@ -48,21 +177,67 @@ private:
 	float m_cViewCnt = 2.f;
 	int m_minCheckCnt = 2;
 	bool m_nodeMultiplex = false;
+	int m_cliqueBudget = 0;
+	float m_cliqueTimeBudget = 0.f;
+	long long m_nodeBudget = 0;
+	int m_cliqueCnt = 0;
+	long long m_nodeCnt = 0;
+	int m_budgetFrameCnt = 0;
+	int m_budgetHitCnt = 0;
+	bool m_budgetHit = false;
+	int m_popCnt = 0;
+	double m_popTime = 0.;
+
+	std::vector<int> m_viewCandiOffsets;									// m_viewCandiOffsets[view], first candidate of the view in the frame
+	int m_candiSize = 0;													// candidates of all views and joints of the frame
+	std::vector<int> m_candiSlots;											// m_candiSlots[candidate], its column in the joint cache of its span
+	long long m_jointCacheHitCnt = 0, m_jointCacheMissCnt = 0;
+	long long m_personCacheHitCnt = 0, m_personCacheMissCnt = 0;
+
+	bool m_fastPath = false;
+	float m_minClaimRatio = 0.8f;
+	float m_fastPathRatio = 0.f;
+
+	bool m_splitComponents = false;
+	std::vector<int> m_componentParents;									// union find over the candidates, then the tracked persons
+	std::vector<int> m_componentLabels;										// m_componentLabels[root], span of the component or -1
+	std::vector<SpanContext> m_spans;										// the spans of the last frame, m_spanSize of them
+	int m_spanSize = 0;
+	std::vector<std::tuple<float, int, int>> m_newPersons;					// (-birth score, span, pIdx) of the spans' new persons
 
+	void ClaimTracked();
 	void CalcBoneNodes();
 	void CalcBoneEpiEdges();
 	void CalcBoneTempEdges();
-	void EnumCliques(std::vector<BoneClique>& cliques);
-	void PushClique(const int& pafIdx, const Eigen::VectorXi& proposal, std::vector<BoneClique>& cliques);
+	void CalcCliqueBits();
+	void CalcComponents();
+	int GetComponent(const int& node);
+	SpanContext& NewSpan();
+	void EnumCliques(const bool& split);
+	void MergeSpans();
+	Eigen::Map<Eigen::VectorXi> NewProposal(SpanContext& span);
+	int* SearchPicks(const int& slot) { return m_searchPicks.data() + slot * (m_cams.size() + 1); }
+	uint64_t* SearchBits(const int& slot) { return m_searchBits.data() + slot * (m_cams.size() + 1) * m_searchWordSize; }
+	int NewSearchSlot();
+	void InitCliqueSearch();
+	float CalcCliqueBound(const int& pafIdx, const int& index, const int& slot);
+	void PushSearchNode(const int& pafIdx, const int& index, const int& slot);
+	bool SearchClique(SpanContext& span, const float& minScore);
+	void PushClique(SpanContext& span, const int& pafIdx, const Eigen::Ref<const Eigen::VectorXi>& proposal);
 	void CalcCliqueScore(BoneClique& clique);
-	int CheckJointCompatibility(const int& view, const int& jIdx, const int& candiIdx, const int& personIdx);
-	int CheckPersonCompatibility(const int& masterIdx, const int& slaveIdx, const int& view);
-	int CheckPersonCompatibility(const int& masterIdx, const int& slaveIdx);
-	void MergePerson(const int& masterIdx, const int& slaveIdx);
-	void AssignTopClique(std::vector<BoneClique>& cliques);
+	void TouchPerson(SpanContext& span, const int& pIdx);
+	void InitCompatibilityCache();
+	void CalcCandiSlots(const bool& split);
+	int CheckJointCompatibility(SpanContext& span, const int& view, const int& jIdx, const int& candiIdx, const int& personIdx);
+	int CalcJointCompatibility(SpanContext& span, const int& view, const int& jIdx, const int& candiIdx, const int& personIdx);
+	int CheckPersonCompatibility(SpanContext& span, const int& masterIdx, const int& slaveIdx, const int& view);
+	int CheckPersonCompatibility(SpanContext& span, const int& masterIdx, const int& slaveIdx);
+	int CalcPersonCompatibility(SpanContext& span, const int& masterIdx, const int& slaveIdx);
+	void MergePerson(SpanContext& span, const int& masterIdx, const int& slaveIdx);
+	void AssignTopClique(SpanContext& span);
 	void SpanTree();
-	void DismemberPersons(std::vector<BoneClique>& cliques);
-	void Clique2Voting(const BoneClique& clique, Voting& voting);
+	void DismemberPersons(SpanContext& span);
+	void Clique2Voting(SpanContext& span, const BoneClique& clique, Voting& voting);
 };
 
 
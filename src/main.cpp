@@ -1,39 +1,84 @@
 #include "kruskal_associater.h"
 #include "skel_updater.h"
 #include "skel_painter.h"
-#include "openpose.h"
+#include "detection_stream.h"
+#include "detection_ring.h"
+#include "skel_snapshot.h"
+#include "pipeline.h"
+#include "video_sink.h"
 #include <opencv2/opencv.hpp>
 #include <Eigen/Eigen>
 #include <json/json.h>
 
 
-int main()
+// state of one frame handed between the pipeline stages
+struct Frame
 {
+	int frameIdx = -1;
+	bool render = false;
+	std::vector<cv::Mat> rawImgs;
+	std::vector<OpenposeDetection> detections;
+	std::map<int, Eigen::Matrix3Xf> skels2d;
+	std::map<int, Eigen::Matrix4Xf> skels3d;
+};
+
+
+int main(int argc, char** argv)
+{
+	// --headless tracks without opening any video, --render N only decodes and renders every Nth frame,
+	// --drop skips rendering frames while the video encoders are behind instead of waiting for them,
+	// --ring NAME takes the detections from the shared memory ring of a live detector (or detection_replay),
+	// --fixed-gate gates the temporal edges around the last skeletons instead of their motion prediction
+	int renderInterval = 1;
+	bool dropFrames = false;
+	bool predictMotion = true;
+	std::string ringName;
+	for (int i = 1; i < argc; i++) {
+		if (std::string(argv[i]) == "--headless")
+			renderInterval = 0;
+		else if (std::string(argv[i]) == "--render" && i + 1 < argc)
+			renderInterval = std::max(std::stoi(argv[++i]), 0);
+		else if (std::string(argv[i]) == "--drop")
+			dropFrames = true;
+		else if (std::string(argv[i]) == "--ring" && i + 1 < argc)
+			ringName = argv[++i];
+		else if (std::string(argv[i]) == "--fixed-gate")
+			predictMotion = false;
+	}
+	const bool headless = renderInterval == 0;
+
 	const std::string dataset = "seq_3";
 	std::map<std::string, Camera> cameras = ParseCameras("../data/" + dataset + "/calibration.json");
 	Eigen::Matrix3Xf projs(3, cameras.size() * 4);
-	std::vector<cv::Mat> rawImgs(cameras.size());
 	std::vector<cv::VideoCapture> videos(cameras.size());
-	std::vector<std::vector<OpenposeDetection>> seqDetections(cameras.size());
+	std::vector<cv::Size> imgSizes(cameras.size());
+	std::vector<std::string> detectionFiles(cameras.size());
 	const SkelDef& skelDef = GetSkelDef(SKEL19);
-	std::vector<std::map<int, Eigen::Matrix4Xf>> skels;
 
 #pragma omp parallel for
 	for (int i = 0; i < cameras.size(); i++) {
 		auto iter = std::next(cameras.begin(), i);
-		videos[i] = cv::VideoCapture("../data/" + dataset + "/video/" + iter->first + ".avi");
-		videos[i].set(cv::CAP_PROP_POS_FRAMES, 0);
-
 		projs.middleCols(4 * i, 4) = iter->second.eiProj;
-		seqDetections[i] = ParseDetections("../data/" + dataset + "/detection/" + iter->first + ".txt");
-		cv::Size imgSize(int(videos[i].get(cv::CAP_PROP_FRAME_WIDTH)), int(videos[i].get(cv::CAP_PROP_FRAME_HEIGHT)));
-		for (auto&& detection : seqDetections[i]) {
-			for (auto&& joints : detection.joints) {
-				joints.row(0) *= (imgSize.width - 1);
-				joints.row(1) *= (imgSize.height - 1);
-			}
+		detectionFiles[i] = "../data/" + dataset + "/detection/" + iter->first + ".txt";
+		if (headless)
+			imgSizes[i] = iter->second.imgSize;
+		else {
+			videos[i] = cv::VideoCapture("../data/" + dataset + "/video/" + iter->first + ".avi");
+			videos[i].set(cv::CAP_PROP_POS_FRAMES, 0);
+			imgSizes[i] = cv::Size(int(videos[i].get(cv::CAP_PROP_FRAME_WIDTH)), int(videos[i].get(cv::CAP_PROP_FRAME_HEIGHT)));
 		}
-		rawImgs[i].create(imgSize, CV_8UC3);
+	}
+	DetectionPreprocess preprocess;
+	preprocess.type = SKEL19;
+	preprocess.imgSizes = imgSizes;
+	preprocess.normalizePaf = true;				// same as associater.SetNormalizeEdge
+	std::unique_ptr<DetectionStream> detectionStream;
+	DetectionRingReader ringReader;
+	if (ringName.empty())
+		detectionStream = std::make_unique<DetectionStream>(detectionFiles, preprocess);
+	else if (!ringReader.Open(ringName) || ringReader.GetViewSize() != cameras.size()) {
+		std::cerr << "can not open detection ring of " << cameras.size() << " views: " << ringName << std::endl;
+		return 1;
 	}
 
 	KruskalAssociater associater(SKEL19, cameras);
@@ -49,57 +94,126 @@ int main()
 	associater.SetNodeMultiplex(true);
 	associater.SetNormalizeEdge(true);			// new feature
 
+	SkelFileWriter skelWriter("../output/skel.bin", skelDef.jointSize);
+	SkelSnapshotWriter snapshotWriter;
+	if (!snapshotWriter.Create("4d_association", SKEL19))
+		std::cerr << "can not create skel snapshot" << std::endl;
 	SkelPainter skelPainter(SKEL19);
 	skelPainter.rate = 512.f / float(cameras.begin()->second.imgSize.width);
 	SkelFittingUpdater skelUpdater(SKEL19, "../data/skel/SKEL19_new");
 	skelUpdater.SetTemporalTransTerm(1e-1f / std::powf(skelPainter.rate, 2));
 	skelUpdater.SetTemporalPoseTerm(1e-1f / std::powf(skelPainter.rate, 2));
-	cv::Mat detectImg, assocImg, reprojImg;
-	cv::Mat resizeImg;
-	for (int frameIdx = 0; ; frameIdx++) {
+	// decode of frame t + 2, tracking of t + 1 and rendering of t overlap, tracking stays one stage
+	// since association needs the skeletons fitted on the previous frame.
+	// the detection stream or ring sets the sequence length, videos are only decoded for rendered frames
+	Pipeline<Frame> pipeline;
+	int decodeIdx = 0;
+	pipeline.SetSource("decode", [&](Frame& frame) {
+		if (detectionStream) {
+			if (!detectionStream->Read(frame.detections))
+				return false;
+			frame.frameIdx = decodeIdx++;
+		}
+		else {
+			// the ring carries raw detections, frames it dropped are skipped in the videos too
+			double timestamp;
+			if (!ringReader.Read(frame.detections, timestamp))
+				return false;
+			for (int view = 0; view < cameras.size(); view++)
+				preprocess.Apply(view, frame.detections[view]);
+			frame.frameIdx = int(ringReader.GetFrameIdx());
+			for (; decodeIdx < frame.frameIdx && !headless; decodeIdx++)
+				for (int view = 0; view < cameras.size(); view++)
+					videos[view].grab();
+			decodeIdx = frame.frameIdx + 1;
+		}
+		frame.render = !headless && frame.frameIdx % renderInterval == 0;
+		if (headless)
+			return true;
+
+		frame.rawImgs.resize(cameras.size());
 		bool flag = true;
+#pragma omp parallel for reduction(&&:flag)
 		for (int view = 0; view < cameras.size(); view++) {
-			videos[view] >> rawImgs[view];
-			if (rawImgs[view].empty()) {
-				flag = false;
-				break;
+			if (!frame.render)
+				flag = videos[view].grab();
+			else {
+				videos[view] >> frame.rawImgs[view];
+				if (frame.rawImgs[view].empty())
+					flag = false;
+				else
+					cv::resize(frame.rawImgs[view], frame.rawImgs[view], cv::Size(), skelPainter.rate, skelPainter.rate);
 			}
-			cv::resize(rawImgs[view], rawImgs[view], cv::Size(), skelPainter.rate, skelPainter.rate);
-			associater.SetDetection(view, seqDetections[view][frameIdx].Mapping(SKEL19));
 		}
-		if (!flag)
-			break;
+		return flag;
+	});
 
-		associater.SetSkels3dPrev(skelUpdater.GetSkel3d());
+	pipeline.AddStage("track", [&](Frame& frame) {
+		// the detections are moved through, a rendered frame takes them back to draw them once associated
+		associater.SetDetections(std::move(frame.detections));
+		if (predictMotion)
+			associater.SetSkels3dPrev(skelUpdater.GetPredictedSkel3d(), skelUpdater.GetPredictionErrors());
+		else
+			associater.SetSkels3dPrev(skelUpdater.GetSkel3d());
 		associater.Associate();
+		if (frame.render)
+			frame.detections = associater.TakeDetections();
 		skelUpdater.Update(associater.GetSkels2d(), projs);
+		snapshotWriter.Publish(skelUpdater, frame.frameIdx);
+		skelWriter.Write(skelUpdater.GetSkel3d());
+		if (frame.render) {
+			frame.skels2d = associater.GetSkels2d();
+			frame.skels3d = skelUpdater.GetSkel3d();
+		}
+		std::cout << std::to_string(frame.frameIdx) << std::endl;
+	});
 
-		
-		// save
-		const int layoutCols = 3;
-		std::vector<cv::Rect> rois = SkelPainter::MergeImgs(rawImgs, detectImg, layoutCols,
-			{ rawImgs.begin()->cols, rawImgs.begin()->rows});
-		detectImg.copyTo(assocImg);
-		detectImg.copyTo(reprojImg);
+	std::unique_ptr<VideoSink> videoSink;
+	if (!headless) {
+		const double fps = videos.begin()->get(cv::CAP_PROP_FPS);
+		videoSink = std::make_unique<VideoSink>(std::vector<std::string>({
+			"../output/detect.mp4", "../output/assoc.mp4", "../output/reproj.mp4" }),
+			(fps > 0. ? fps : 25.) / renderInterval, 4, dropFrames);
 
-#pragma omp parallel for
-		for (int view = 0; view < cameras.size(); view++) {
-			const OpenposeDetection detection = seqDetections[view][frameIdx].Mapping(SKEL19);
-			skelPainter.DrawDetect(detection.joints, detection.pafs, detectImg(rois[view]));
-			for (const auto& skel2d : associater.GetSkels2d())
-				skelPainter.DrawAssoc(skel2d.second.middleCols(view * skelDef.jointSize, skelDef.jointSize), assocImg(rois[view]), skel2d.first);
+		pipeline.AddStage("render", [&](Frame& frame) {
+			if (!frame.render)
+				return;
+			const int bufferIdx = videoSink->Acquire();
+			if (bufferIdx < 0)
+				return;
+			std::vector<cv::Mat>& mosaics = videoSink->GetMosaics(bufferIdx);
+			cv::Mat& detectImg = mosaics[0];
+			cv::Mat& assocImg = mosaics[1];
+			cv::Mat& reprojImg = mosaics[2];
+			const int layoutCols = 3;
+			std::vector<cv::Rect> rois = SkelPainter::MergeImgs(frame.rawImgs, detectImg, layoutCols,
+				{ frame.rawImgs.begin()->cols, frame.rawImgs.begin()->rows});
+			detectImg.copyTo(assocImg);
+			detectImg.copyTo(reprojImg);
 
-			for(const auto& skel3d : skelUpdater.GetSkel3d())
-				skelPainter.DrawReproj(skel3d.second, projs.middleCols(4 * view, 4), reprojImg(rois[view]), skel3d.first);
-		}
+#pragma omp parallel for
+			for (int view = 0; view < cameras.size(); view++) {
+				const OpenposeDetection& detection = frame.detections[view];
+				skelPainter.DrawDetect(detection.joints, detection.pafs, detectImg(rois[view]));
+				for (const auto& skel2d : frame.skels2d)
+					skelPainter.DrawAssoc(skel2d.second.middleCols(view * skelDef.jointSize, skelDef.jointSize), assocImg(rois[view]), skel2d.first);
 
-		skels.emplace_back(skelUpdater.GetSkel3d());
-		cv::imwrite("../output/detect/" + std::to_string(frameIdx) + ".jpg", detectImg);
-		cv::imwrite("../output/assoc/" + std::to_string(frameIdx) + ".jpg", assocImg);
-		cv::imwrite("../output/reproj/" + std::to_string(frameIdx) + ".jpg", reprojImg);
-		std::cout << std::to_string(frameIdx) << std::endl;
+				for(const auto& skel3d : frame.skels3d)
+					skelPainter.DrawReproj(skel3d.second, projs.middleCols(4 * view, 4), reprojImg(rois[view]), skel3d.first);
+			}
+			videoSink->Submit(bufferIdx);
+		});
 	}
 
-	SerializeSkels(skels, "../output/skel.txt");
+	pipeline.Run();
+	pipeline.PrintStats(std::cout);
+	if (!ringName.empty())
+		std::cout << "detection ring: " << ringReader.GetDropCnt() << " corrupted frames dropped" << std::endl;
+	if (videoSink) {
+		videoSink->Close();
+		std::cout << "video: " << videoSink->GetEncodeCnt() << " frames encoded of " << videoSink->GetSubmitCnt() << " submitted, "
+			<< videoSink->GetDropCnt() << " dropped" << std::endl;
+	}
+	skelWriter.Close();
 	return 0;
 }
@@ -0,0 +1,96 @@
+#include "mapped_file.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+#ifdef _WIN32
+bool MappedFile::Open(const std::string& filename)
+{
+	Close();
+	m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+	if (m_file == INVALID_HANDLE_VALUE) {
+		m_file = nullptr;
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+		Close();
+		return false;
+	}
+	m_size = size_t(size.QuadPart);
+
+	m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_mapping == NULL) {
+		m_mapping = nullptr;
+		Close();
+		return false;
+	}
+
+	m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	if (m_data == nullptr) {
+		Close();
+		return false;
+	}
+	return true;
+}
+
+
+void MappedFile::Close()
+{
+	if (m_data != nullptr)
+		UnmapViewOfFile(m_data);
+	if (m_mapping != nullptr)
+		CloseHandle(m_mapping);
+	if (m_file != nullptr)
+		CloseHandle(m_file);
+	m_data = nullptr;
+	m_mapping = m_file = nullptr;
+	m_size = 0;
+}
+
+#else
+bool MappedFile::Open(const std::string& filename)
+{
+	Close();
+	m_fd = open(filename.c_str(), O_RDONLY);
+	if (m_fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(m_fd, &st) != 0 || st.st_size == 0) {
+		Close();
+		return false;
+	}
+	m_size = size_t(st.st_size);
+
+	void* data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+	if (data == MAP_FAILED) {
+		Close();
+		return false;
+	}
+	madvise(data, m_size, MADV_RANDOM);
+	m_data = static_cast<const char*>(data);
+	return true;
+}
+
+
+void MappedFile::Close()
+{
+	if (m_data != nullptr)
+		munmap(const_cast<char*>(m_data), m_size);
+	if (m_fd >= 0)
+		close(m_fd);
+	m_data = nullptr;
+	m_fd = -1;
+	m_size = 0;
+}
+#endif
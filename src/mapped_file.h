@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+
+// read-only memory mapping of a whole file, pages are only loaded when touched
+class MappedFile
+{
+public:
+	MappedFile() {}
+	MappedFile(const std::string& filename) { Open(filename); }
+	~MappedFile() { Close(); }
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::string& filename);
+	void Close();
+	bool IsOpen() const { return m_data != nullptr; }
+	const char* GetData() const { return m_data; }
+	size_t GetSize() const { return m_size; }
+
+private:
+	const char* m_data = nullptr;
+	size_t m_size = 0;
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#else
+	int m_fd = -1;
+#endif
+};
@@ -2,9 +2,13 @@
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <vector>
+#include <algorithm>
 #include <type_traits>
 #include <Eigen/Core>
 #include <opencv2/core.hpp>
+#include "mapped_file.h"
+#include "text_parser.h"
 
 
 namespace MathUtil {
@@ -83,19 +87,55 @@ namespace MathUtil {
 		return 1 - exp(-x * x / 2);
 	}
 
+	// false on a missing or invalid file
+	template <typename T>
+	bool LoadMat(const std::string& filename, Eigen::Matrix<T, -1, -1>& _mat) {
+		const MappedFile file(filename);
+		if (!file.IsOpen()) {
+			std::cerr << "can not open fie: " << filename << std::endl;
+			return false;
+		}
+		TextParser parser(file.GetData(), file.GetData() + file.GetSize());
+		const int rows = parser.Parse<int>();
+		const int cols = parser.Parse<int>();
+		bool fail = parser.Fail() || rows < 0 || cols < 0;
+
+		// locate row blocks by skipping tokens, then convert the blocks in parallel. a truncated file fails the scan,
+		// before any block is converted from a position the scan never reached
+		const int blockRows = 64;
+		std::vector<const char*> blockBegins(fail ? 0 : (rows + blockRows - 1) / blockRows);
+		for (int block = 0; block < blockBegins.size() && !fail; block++) {
+			blockBegins[block] = parser.GetPos();
+			parser.Skip(std::min(blockRows, rows - block * blockRows) * cols);
+			fail = parser.Fail();
+		}
+		if (fail) {
+			std::cerr << "invalid mat file: " << filename << std::endl;
+			return false;
+		}
+
+		Eigen::Matrix<T, -1, -1, Eigen::RowMajor> mat(rows, cols);
+#pragma omp parallel for reduction(||:fail)
+		for (int block = 0; block < blockBegins.size(); block++) {
+			TextParser blockParser(blockBegins[block], file.GetData() + file.GetSize());
+			const int blockSize = std::min(blockRows, rows - block * blockRows) * cols;
+			blockParser.Parse(mat.data() + block * blockRows * cols, blockSize);
+			fail = fail || blockParser.Fail();
+		}
+
+		if (fail) {
+			std::cerr << "invalid mat file: " << filename << std::endl;
+			return false;
+		}
+		_mat = mat;
+		return true;
+	}
+
 	template <typename T>
 	Eigen::Matrix<T, -1, -1> LoadMat(const std::string& filename) {
-		std::ifstream ifs(filename);
-		if (!ifs.is_open()) {
-			std::cerr << "can not open fie: " << filename;
+		Eigen::Matrix<T, -1, -1> mat;
+		if (!LoadMat(filename, mat))
 			std::abort();
-		}
-		int rows, cols;
-		ifs >> rows >> cols;
-		Eigen::Matrix<T, -1, -1> mat(rows, cols);
-		for (int i = 0; i < rows; i++)
-			for (int j = 0; j < cols; j++)
-				ifs >> mat(i, j);
 		return mat;
 	}
 
@@ -1,6 +1,10 @@
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
 #include <opencv2/opencv.hpp>
 #include "skel_painter.h"
 #include "openpose.h"
+#include "text_parser.h"
 
 
 OpenposeDetection::OpenposeDetection(const SkelType& _type)
@@ -25,10 +29,64 @@ OpenposeDetection OpenposeDetection::Mapping(const SkelType& tarType)
 		if (_pafIdx != -1)
 			detection.pafs[_pafIdx] = pafs[pafIdx];
 	}
+	detection.state = state;
 	return detection;
 }
 
 
+void OpenposeDetection::ScaleToPixel(const cv::Size& imgSize)
+{
+	if (state & DETECTION_PIXEL)
+		return;
+	for (auto&& _joints : joints) {
+		_joints.row(0) *= (imgSize.width - 1);
+		_joints.row(1) *= (imgSize.height - 1);
+	}
+	state |= DETECTION_PIXEL;
+}
+
+
+void OpenposeDetection::NormalizePaf(const int& pafIdx)
+{
+	// factors go to reused buffers, the associater normalizes every frame
+	auto&& paf = pafs[pafIdx];
+	if (paf.size() > 0) {
+		thread_local std::vector<float> rowFactor, colFactor;
+		rowFactor.resize(paf.rows());
+		colFactor.resize(paf.cols());
+		for (int i = 0; i < paf.rows(); i++)
+			rowFactor[i] = std::max(paf.row(i).sum(), 1.f);
+		for (int i = 0; i < paf.cols(); i++)
+			colFactor[i] = std::max(paf.col(i).sum(), 1.f);
+		for (int i = 0; i < paf.rows(); i++)
+			paf.row(i) /= rowFactor[i];
+		for (int i = 0; i < paf.cols(); i++)
+			paf.col(i) /= colFactor[i];
+	}
+}
+
+
+void OpenposeDetection::NormalizePafs()
+{
+	if (state & DETECTION_PAF_NORMALIZED)
+		return;
+	for (int pafIdx = 0; pafIdx < pafs.size(); pafIdx++)
+		NormalizePaf(pafIdx);
+	state |= DETECTION_PAF_NORMALIZED;
+}
+
+
+void DetectionPreprocess::Apply(const int& view, OpenposeDetection& detection) const
+{
+	if (!imgSizes.empty())
+		detection.ScaleToPixel(imgSizes[view]);
+	if (type != SKEL_TYPE_NONE && detection.type != type)
+		detection = detection.Mapping(type);
+	if (normalizePaf)
+		detection.NormalizePafs();
+}
+
+
 std::vector<Eigen::Matrix3Xf> OpenposeDetection::Associate(const int& jcntThresh)
 {
 	const SkelDef& def = GetSkelDef(type);
@@ -156,39 +214,131 @@ std::vector<Eigen::Matrix3Xf> OpenposeDetection::Associate(const int& jcntThresh
 
 std::vector<OpenposeDetection> ParseDetections(const std::string& filename)
 {
-	std::ifstream fs(filename);
-	if (!fs.is_open()) {
-		std::cerr << "file not exist: " << filename << std::endl;
+	std::vector<OpenposeDetection> detections;
+	if (!ParseDetections(filename, detections))
 		std::abort();
+	return detections;
+}
+
+
+bool ParseDetections(const std::string& filename, std::vector<OpenposeDetection>& detections)
+{
+	if (IsDetectionFile(filename)) {
+		DetectionFile file;
+		if (!file.Open(filename))
+			return false;
+		detections.resize(file.GetFrameSize());
+		for (int frameIdx = 0; frameIdx < file.GetFrameSize(); frameIdx++)
+			if (!file.ReadDetection(frameIdx, detections[frameIdx]))
+				return false;
+		return true;
 	}
 
-	int skelType, frameSize;
-	fs >> skelType >> frameSize;
+	const MappedFile file(filename);
+	if (!file.IsOpen()) {
+		std::cerr << "file not exist: " << filename << std::endl;
+		return false;
+	}
 
-	const SkelDef& def = GetSkelDef(SkelType(skelType));
-	std::vector<OpenposeDetection> detections(frameSize, OpenposeDetection(SkelType(skelType)));
-	for (OpenposeDetection& detection : detections) {
-		for (int jIdx = 0; jIdx < def.jointSize; jIdx++) {
-			int jSize;
-			fs >> jSize;
-			detection.joints[jIdx].resize(3, jSize);
-			for (int i = 0; i < 3; i++)
-				for (int j = 0; j < jSize; j++)
-					fs >> detection.joints[jIdx](i, j);
+	// locate frames by skipping tokens, candidate counts are the only values converted here. a truncated file fails
+	// here, before any frame is converted from a position the scan never reached
+	TextParser parser(file.GetData(), file.GetData() + file.GetSize());
+	const SkelType type = SkelType(parser.Parse<int>());
+	const int frameSize = parser.Parse<int>();
+	if (parser.Fail() || type < 0 || type >= SKEL_TYPE_SIZE || frameSize < 0) {
+		std::cerr << "invalid detection file: " << filename << std::endl;
+		return false;
+	}
+
+	const SkelDef& def = GetSkelDef(type);
+	std::vector<const char*> frameBegins(frameSize);
+	Eigen::VectorXi jSizes(def.jointSize);
+	bool fail = false;
+	for (int frameIdx = 0; frameIdx < frameSize && !fail; frameIdx++) {
+		frameBegins[frameIdx] = parser.GetPos();
+		for (int jIdx = 0; jIdx < def.jointSize && !fail; jIdx++) {
+			jSizes[jIdx] = parser.Parse<int>();
+			parser.Skip(3 * std::max(jSizes[jIdx], 0));
+			fail = parser.Fail() || jSizes[jIdx] < 0;
 		}
-		for (int pafIdx = 0; pafIdx < def.pafSize; pafIdx++) {
-			const int jAIdx = def.pafDict(0, pafIdx);
-			const int jBIdx = def.pafDict(1, pafIdx);
-			detection.pafs[pafIdx].resize(detection.joints[jAIdx].cols(), detection.joints[jBIdx].cols());
-			for (int i = 0; i < detection.pafs[pafIdx].rows(); i++)
-				for (int j = 0; j < detection.pafs[pafIdx].cols(); j++)
-					fs >> detection.pafs[pafIdx](i, j);
-
-			detection.pafs[pafIdx] = detection.pafs[pafIdx].array().pow(0.2f);
+		for (int pafIdx = 0; pafIdx < def.pafSize && !fail; pafIdx++) {
+			parser.Skip(jSizes[def.pafDict(0, pafIdx)] * jSizes[def.pafDict(1, pafIdx)]);
+			fail = parser.Fail();
 		}
 	}
-	fs.close();
-	return detections;
+	if (fail) {
+		std::cerr << "invalid detection file: " << filename << std::endl;
+		return false;
+	}
+
+	detections.assign(frameSize, OpenposeDetection());
+#pragma omp parallel for reduction(||:fail)
+	for (int frameIdx = 0; frameIdx < frameSize; frameIdx++) {
+		TextParser frameParser(frameBegins[frameIdx], file.GetData() + file.GetSize());
+		fail = !ParseDetection(frameParser, type, detections[frameIdx]) || fail;
+	}
+
+	if (fail) {
+		std::cerr << "invalid detection file: " << filename << std::endl;
+		return false;
+	}
+	return true;
+}
+
+
+bool ParseDetection(TextParser& parser, const SkelType& type, OpenposeDetection& detection)
+{
+	// a candidate count is only trusted once the rest of the buffer can hold its values
+	const SkelDef& def = GetSkelDef(type);
+	detection = OpenposeDetection(type);
+	for (int jIdx = 0; jIdx < def.jointSize; jIdx++) {
+		const int jSize = parser.Parse<int>();
+		if (parser.Fail() || jSize < 0 || 3 * uint64_t(jSize) > parser.GetRestSize())
+			return false;
+		Eigen::Matrix<float, 3, -1, Eigen::RowMajor> joints(3, jSize);
+		parser.Parse(joints.data(), int(joints.size()));
+		detection.joints[jIdx] = joints;
+	}
+	for (int pafIdx = 0; pafIdx < def.pafSize; pafIdx++) {
+		Eigen::Matrix<float, -1, -1, Eigen::RowMajor> paf(
+			detection.joints[def.pafDict(0, pafIdx)].cols(), detection.joints[def.pafDict(1, pafIdx)].cols());
+		if (uint64_t(paf.size()) > parser.GetRestSize())
+			return false;
+		parser.Parse(paf.data(), int(paf.size()));
+		detection.pafs[pafIdx] = paf;
+		detection.pafs[pafIdx] = detection.pafs[pafIdx].array().pow(0.2f);
+	}
+	return !parser.Fail();
+}
+
+
+OpenposeDetection ParseDetection(std::istream& fs, const SkelType& type)
+{
+	const SkelDef& def = GetSkelDef(type);
+	OpenposeDetection detection(type);
+	for (int jIdx = 0; jIdx < def.jointSize; jIdx++) {
+		int jSize = -1;
+		fs >> jSize;
+		if (fs.fail() || jSize < 0) {
+			fs.setstate(std::ios::failbit);
+			return detection;
+		}
+		detection.joints[jIdx].resize(3, jSize);
+		for (int i = 0; i < 3; i++)
+			for (int j = 0; j < jSize; j++)
+				fs >> detection.joints[jIdx](i, j);
+	}
+	for (int pafIdx = 0; pafIdx < def.pafSize; pafIdx++) {
+		const int jAIdx = def.pafDict(0, pafIdx);
+		const int jBIdx = def.pafDict(1, pafIdx);
+		detection.pafs[pafIdx].resize(detection.joints[jAIdx].cols(), detection.joints[jBIdx].cols());
+		for (int i = 0; i < detection.pafs[pafIdx].rows(); i++)
+			for (int j = 0; j < detection.pafs[pafIdx].cols(); j++)
+				fs >> detection.pafs[pafIdx](i, j);
+
+		detection.pafs[pafIdx] = detection.pafs[pafIdx].array().pow(0.2f);
+	}
+	return detection;
 }
 
 
@@ -208,3 +358,198 @@ void SerializeDetections(const std::vector<OpenposeDetection>& detections, const
 	fs.close();
 }
 
+
+
+size_t GetDetectionFrameBytes(const OpenposeDetection& detection)
+{
+	size_t bytes = 0;
+	for (const auto& joints : detection.joints)
+		bytes += sizeof(int32_t) + joints.size() * sizeof(float);
+	for (const auto& paf : detection.pafs)
+		bytes += paf.size() * sizeof(float);
+	return bytes;
+}
+
+
+void WriteDetectionFrame(const OpenposeDetection& detection, char* dst)
+{
+	for (const auto& joints : detection.joints) {
+		const int32_t jSize = int32_t(joints.cols());
+		std::memcpy(dst, &jSize, sizeof(jSize));
+		dst += sizeof(jSize);
+		std::memcpy(dst, joints.data(), joints.size() * sizeof(float));
+		dst += joints.size() * sizeof(float);
+	}
+	for (const auto& paf : detection.pafs) {
+		std::memcpy(dst, paf.data(), paf.size() * sizeof(float));
+		dst += paf.size() * sizeof(float);
+	}
+}
+
+
+bool ReadDetectionFrame(const char* data, const size_t& bytes, const SkelType& type, OpenposeDetection& detection)
+{
+	const SkelDef& def = GetSkelDef(type);
+	detection.type = type;
+	detection.state = 0;
+	detection.joints.resize(def.jointSize);
+	detection.pafs.resize(def.pafSize);
+	const char* end = data + bytes;
+	auto Read = [&](void* dst, const size_t& size) {
+		if (size_t(end - data) < size)
+			return false;
+		std::memcpy(dst, data, size);
+		data += size;
+		return true;
+	};
+
+	for (int jIdx = 0; jIdx < def.jointSize; jIdx++) {
+		int32_t jSize;
+		if (!Read(&jSize, sizeof(jSize)) || jSize < 0)
+			return false;
+		detection.joints[jIdx].resize(3, jSize);
+		if (!Read(detection.joints[jIdx].data(), detection.joints[jIdx].size() * sizeof(float)))
+			return false;
+	}
+
+	for (int pafIdx = 0; pafIdx < def.pafSize; pafIdx++) {
+		const int jAIdx = def.pafDict(0, pafIdx);
+		const int jBIdx = def.pafDict(1, pafIdx);
+		detection.pafs[pafIdx].resize(detection.joints[jAIdx].cols(), detection.joints[jBIdx].cols());
+		if (!Read(detection.pafs[pafIdx].data(), detection.pafs[pafIdx].size() * sizeof(float)))
+			return false;
+	}
+	return true;
+}
+
+
+bool IsDetectionFile(const std::string& filename)
+{
+	std::ifstream fs(filename, std::ios::binary);
+	char magic[4] = { 0 };
+	fs.read(magic, sizeof(magic));
+	return fs.good() && std::memcmp(magic, "4DDT", sizeof(magic)) == 0;
+}
+
+
+void SerializeDetectionFile(const std::vector<OpenposeDetection>& detections, const std::string& filename)
+{
+	const SkelType type = detections.empty() ? SKEL_TYPE_NONE : detections.begin()->type;
+	std::ofstream fs(filename, std::ios::binary);
+	if (!fs.is_open()) {
+		std::cerr << "can not open file: " << filename << std::endl;
+		std::abort();
+	}
+
+	DetectionFileHeader header;
+	std::memcpy(header.magic, "4DDT", sizeof(header.magic));
+	header.version = DETECTION_FILE_VERSION;
+	header.skelType = int32_t(type);
+	header.frameSize = int32_t(detections.size());
+	header.state = detections.empty() ? 0 : detections.begin()->state;
+	header.reserved = 0;
+
+	// frame offsets are known up front since every block size follows from the candidate counts
+	std::vector<uint64_t> offsets(detections.size() + 1);
+	offsets[0] = sizeof(DetectionFileHeader) + offsets.size() * sizeof(uint64_t);
+	for (int frameIdx = 0; frameIdx < detections.size(); frameIdx++)
+		offsets[frameIdx + 1] = offsets[frameIdx] + GetDetectionFrameBytes(detections[frameIdx]);
+
+	fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	fs.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+	std::vector<char> buffer;
+	for (const OpenposeDetection& detection : detections) {
+		assert(detection.type == type && detection.state == header.state);
+		buffer.resize(GetDetectionFrameBytes(detection));
+		WriteDetectionFrame(detection, buffer.data());
+		fs.write(buffer.data(), buffer.size());
+	}
+	fs.close();
+}
+
+
+DetectionFile::DetectionFile(const std::string& filename)
+{
+	if (!Open(filename))
+		std::abort();
+}
+
+
+bool DetectionFile::Open(const std::string& filename)
+{
+	m_type = SKEL_TYPE_NONE;
+	m_frameSize = 0;
+	m_state = 0;
+	m_offsets = nullptr;
+	if (!m_file.Open(filename)) {
+		std::cerr << "file not exist: " << filename << std::endl;
+		return false;
+	}
+
+	// version 1 header ends before the state field
+	DetectionFileHeader header = {};
+	const size_t headerV1Size = offsetof(DetectionFileHeader, state);
+	if (m_file.GetSize() < headerV1Size) {
+		std::cerr << "invalid detection file: " << filename << std::endl;
+		m_file.Close();
+		return false;
+	}
+	std::memcpy(&header, m_file.GetData(), headerV1Size);
+	if (std::memcmp(header.magic, "4DDT", sizeof(header.magic)) != 0 || header.version < 1 || header.version > DETECTION_FILE_VERSION) {
+		std::cerr << "unsupported detection file: " << filename << std::endl;
+		m_file.Close();
+		return false;
+	}
+	const size_t headerSize = header.version == 1 ? headerV1Size : sizeof(header);
+	if (m_file.GetSize() < headerSize) {
+		std::cerr << "invalid detection file: " << filename << std::endl;
+		m_file.Close();
+		return false;
+	}
+	std::memcpy(&header, m_file.GetData(), headerSize);
+
+	if (header.skelType < 0 || header.skelType >= SKEL_TYPE_SIZE) {
+		std::cerr << "invalid detection file, skel type " << header.skelType << ": " << filename << std::endl;
+		m_file.Close();
+		return false;
+	}
+
+	// frames lie between the end of the index and the end of the file, each one starting where the last one ended
+	const uint64_t* offsets = reinterpret_cast<const uint64_t*>(m_file.GetData() + headerSize);
+	const uint64_t indexEnd = headerSize + (uint64_t(std::max(header.frameSize, 0)) + 1) * sizeof(uint64_t);
+	bool valid = header.frameSize >= 0 && indexEnd <= m_file.GetSize() && offsets[0] >= indexEnd;
+	for (int frameIdx = 0; frameIdx < header.frameSize && valid; frameIdx++)
+		valid = offsets[frameIdx + 1] >= offsets[frameIdx];
+	if (!valid || offsets[header.frameSize] > m_file.GetSize()) {
+		std::cerr << "truncated detection file: " << filename << std::endl;
+		m_file.Close();
+		return false;
+	}
+
+	m_type = SkelType(header.skelType);
+	m_frameSize = header.frameSize;
+	m_state = header.state;
+	m_offsets = offsets;
+	return true;
+}
+
+
+OpenposeDetection DetectionFile::GetDetection(const int& frameIdx) const
+{
+	OpenposeDetection detection;
+	if (!ReadDetection(frameIdx, detection))
+		std::abort();
+	return detection;
+}
+
+
+bool DetectionFile::ReadDetection(const int& frameIdx, OpenposeDetection& detection) const
+{
+	assert(frameIdx >= 0 && frameIdx < m_frameSize);
+	if (!ReadDetectionFrame(m_file.GetData() + m_offsets[frameIdx], m_offsets[frameIdx + 1] - m_offsets[frameIdx], m_type, detection)) {
+		std::cerr << "corrupted detection frame: " << frameIdx << std::endl;
+		return false;
+	}
+	detection.state = m_state;
+	return true;
+}
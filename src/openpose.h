@@ -1,9 +1,22 @@
 #pragma once
+#include <cstdint>
 #include <Eigen/Core>
 #include <opencv2/core/cuda.hpp>
 #include <opencv2/core.hpp>
 #include <opencv2/videoio.hpp>
 #include "skel.h"
+#include "mapped_file.h"
+
+
+class TextParser;
+
+
+// preprocessing steps already applied to a detection
+enum DetectionState
+{
+	DETECTION_PIXEL = 1,				// joints scaled from [0, 1] to pixel coordinates
+	DETECTION_PAF_NORMALIZED = 2,		// paf rows and columns normalized for association
+};
 
 
 struct OpenposeDetection
@@ -12,12 +25,74 @@ struct OpenposeDetection
 	OpenposeDetection(const SkelType& _type);
 	OpenposeDetection Mapping(const SkelType& tarType);
 	std::vector<Eigen::Matrix3Xf> Associate(const int& jcntThresh = 5);
+	void ScaleToPixel(const cv::Size& imgSize);
+	void NormalizePaf(const int& pafIdx);
+	void NormalizePafs();
 
 	SkelType type;
+	uint32_t state = 0;
 	std::vector<Eigen::Matrix3Xf> joints;
 	std::vector<Eigen::MatrixXf> pafs;
 };
 
+
+// per-frame transforms applied once when detections are loaded, steps already recorded in the state are skipped
+struct DetectionPreprocess
+{
+	SkelType type = SKEL_TYPE_NONE;		// target skeleton, SKEL_TYPE_NONE keeps the source layout
+	std::vector<cv::Size> imgSizes;		// pixel scale of each view, empty keeps normalized coordinates
+	bool normalizePaf = false;
+
+	void Apply(const int& view, OpenposeDetection& detection) const;
+};
+
 std::vector<OpenposeDetection> ParseDetections(const std::string& filename);
+bool ParseDetections(const std::string& filename, std::vector<OpenposeDetection>& detections);	// false on a missing or invalid file
+OpenposeDetection ParseDetection(std::istream& fs, const SkelType& type);
+bool ParseDetection(TextParser& parser, const SkelType& type, OpenposeDetection& detection);	// one frame, false on an invalid one
 void SerializeDetections(const std::vector<OpenposeDetection>& detections, const std::string& filename);
 
+
+// binary detection file: a fixed header, a per-frame offset index and the raw float data of each frame.
+// frame layout: for each joint an int32 candidate count followed by the 3 x count joints (column major),
+// then for each paf the rows x cols scores (column major). pafs are stored after pow(0.2f) as ParseDetections
+// returns them, state records further preprocessing so a preprocessed sequence can be cached (version 1 has no state).
+struct DetectionFileHeader
+{
+	char magic[4];
+	uint32_t version;
+	int32_t skelType;
+	int32_t frameSize;
+	uint32_t state;
+	uint32_t reserved;
+};
+
+const uint32_t DETECTION_FILE_VERSION = 2;
+size_t GetDetectionFrameBytes(const OpenposeDetection& detection);
+void WriteDetectionFrame(const OpenposeDetection& detection, char* dst);
+bool ReadDetectionFrame(const char* data, const size_t& bytes, const SkelType& type, OpenposeDetection& detection);
+bool IsDetectionFile(const std::string& filename);
+void SerializeDetectionFile(const std::vector<OpenposeDetection>& detections, const std::string& filename);
+
+
+class DetectionFile
+{
+public:
+	DetectionFile() {}
+	DetectionFile(const std::string& filename);
+
+	bool Open(const std::string& filename);	// false on a missing, invalid or truncated file
+	const SkelType& GetType() const { return m_type; }
+	int GetFrameSize() const { return m_frameSize; }
+	uint32_t GetState() const { return m_state; }
+	OpenposeDetection GetDetection(const int& frameIdx) const;
+	bool ReadDetection(const int& frameIdx, OpenposeDetection& detection) const;	// false on a corrupted frame
+
+private:
+	MappedFile m_file;
+	SkelType m_type = SKEL_TYPE_NONE;
+	int m_frameSize = 0;
+	uint32_t m_state = 0;
+	const uint64_t* m_offsets = nullptr;
+};
+
@@ -0,0 +1,52 @@
+#include <cassert>
+#include <algorithm>
+#include "person_store.h"
+
+
+void PersonStore::Reset(const int& jointSize, const int& viewSize)
+{
+	std::fill(m_alive.begin(), m_alive.begin() + m_end, 0);
+	m_size = m_end = 0;
+
+	if (jointSize * viewSize != m_stride)
+		m_data.resize(m_alive.size() * jointSize * viewSize);
+	m_jointSize = jointSize;
+	m_viewSize = viewSize;
+	m_stride = jointSize * viewSize;
+}
+
+
+PersonStore::Person PersonStore::Insert(const int& pIdx)
+{
+	assert(!Contains(pIdx));
+	if (pIdx >= m_alive.size()) {
+		m_alive.resize(pIdx + 1, 0);
+		m_data.resize(m_alive.size() * m_stride);
+	}
+	m_alive[pIdx] = 1;
+	m_size++;
+	m_end = std::max(m_end, pIdx + 1);
+
+	Person person = (*this)[pIdx];
+	person.setConstant(-1);
+	return person;
+}
+
+
+void PersonStore::Erase(const int& pIdx)
+{
+	assert(Contains(pIdx));
+	m_alive[pIdx] = 0;
+	m_size--;
+	while (m_end > 0 && !m_alive[m_end - 1])
+		m_end--;
+}
+
+
+int PersonStore::Next(int pIdx) const
+{
+	for (pIdx++; pIdx < m_end; pIdx++)
+		if (m_alive[pIdx])
+			return pIdx;
+	return m_end;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+#include <Eigen/Core>
+
+
+// persons of an association in a slot map. a person id is its slot and the joint x view candidate matrices are
+// stored back to back at a fixed stride, so finding a person is an index. an erased id may be inserted again, state
+// kept per person elsewhere has to be renewed on insertion. maps returned for a person stay valid until the next
+// insertion.
+class PersonStore
+{
+public:
+	typedef Eigen::Map<Eigen::MatrixXi> Person;
+	typedef Eigen::Map<const Eigen::MatrixXi> ConstPerson;
+
+	void Reset(const int& jointSize, const int& viewSize);
+	Person Insert(const int& pIdx);
+	void Erase(const int& pIdx);
+
+	bool Empty() const { return m_size == 0; }
+	int GetSize() const { return m_size; }
+	bool Contains(const int& pIdx) const { return pIdx >= 0 && pIdx < m_end && m_alive[pIdx]; }
+
+	// ids of the persons ascend from Begin() to End() by Next(), End() is also the smallest id above all persons
+	int Begin() const { return Next(-1); }
+	int End() const { return m_end; }
+	int Next(int pIdx) const;
+
+	Person operator[](const int& pIdx) { return Person(m_data.data() + pIdx * m_stride, m_jointSize, m_viewSize); }
+	ConstPerson operator[](const int& pIdx) const { return ConstPerson(m_data.data() + pIdx * m_stride, m_jointSize, m_viewSize); }
+
+private:
+	int m_jointSize = 0, m_viewSize = 0, m_stride = 0;
+	int m_size = 0, m_end = 0;
+	std::vector<char> m_alive;
+	std::vector<int> m_data;
+};
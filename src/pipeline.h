@@ -0,0 +1,177 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// blocking fifo between two pipeline stages, the producer waits while it holds capacity items
+template<typename T>
+class BoundedQueue
+{
+public:
+	BoundedQueue(const int& capacity) { m_capacity = std::max(capacity, 1); }
+	int GetCapacity() const { return m_capacity; }
+
+	void Push(T&& item)
+	{
+		std::unique_lock<std::mutex> locker(m_mutex);
+		m_pushCond.wait(locker, [&] { return int(m_items.size()) < m_capacity; });
+		m_items.emplace_back(std::move(item));
+		m_popCond.notify_one();
+	}
+
+	// false once the queue is closed and drained
+	bool Pop(T& item)
+	{
+		std::unique_lock<std::mutex> locker(m_mutex);
+		m_popCond.wait(locker, [&] { return !m_items.empty() || m_closed; });
+		if (m_items.empty())
+			return false;
+
+		m_sizeSum += double(m_items.size());
+		m_popCnt++;
+		item = std::move(m_items.front());
+		m_items.pop_front();
+		m_pushCond.notify_one();
+		return true;
+	}
+
+	void Close()
+	{
+		std::unique_lock<std::mutex> locker(m_mutex);
+		m_closed = true;
+		m_popCond.notify_all();
+	}
+
+	// mean number of queued items seen by the consumer, near capacity when the consumer is the bottleneck
+	float GetMeanSize() const
+	{
+		std::unique_lock<std::mutex> locker(m_mutex);
+		return m_popCnt > 0 ? float(m_sizeSum / double(m_popCnt)) : 0.f;
+	}
+
+private:
+	int m_capacity;
+	bool m_closed = false;
+	std::deque<T> m_items;
+	double m_sizeSum = 0.;
+	int m_popCnt = 0;
+	mutable std::mutex m_mutex;
+	std::condition_variable m_pushCond, m_popCond;
+};
+
+
+// runs every stage on its own thread, frames flow from the source through the stages in order over bounded queues,
+// so different frames are processed by different stages at the same time and the slowest stage sets the frame rate
+template<typename Frame>
+class Pipeline
+{
+public:
+	Pipeline(const int& queueCapacity = 2) { m_queueCapacity = queueCapacity; }
+
+	// the source fills a frame and returns false at the end of the sequence. frames leaving the last stage are handed
+	// back to the source with their buffers, so it gets a recycled frame still holding the values of an earlier one
+	// once the pipeline is full
+	void SetSource(const std::string& name, const std::function<bool(Frame&)>& source)
+	{
+		m_stages.insert(m_stages.begin(), Stage{ name, source });
+	}
+
+	void AddStage(const std::string& name, const std::function<void(Frame&)>& stage)
+	{
+		m_stages.emplace_back(Stage{ name, [stage](Frame& frame) { stage(frame); return true; } });
+	}
+
+	void Run()
+	{
+		m_queues.clear();
+		m_pool.clear();
+		for (int stageIdx = 0; stageIdx + 1 < m_stages.size(); stageIdx++)
+			m_queues.emplace_back(std::make_unique<BoundedQueue<Frame>>(m_queueCapacity));
+
+		const auto start = std::chrono::steady_clock::now();
+		std::vector<std::thread> threads;
+		for (int stageIdx = 0; stageIdx < m_stages.size(); stageIdx++)
+			threads.emplace_back(&Pipeline::RunStage, this, stageIdx);
+		for (auto&& thread : threads)
+			thread.join();
+		m_runTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// per stage frame count, frame rate while busy and busy fraction, then the mean occupancy of each queue
+	void PrintStats(std::ostream& os) const
+	{
+		const int frameSize = m_stages.empty() ? 0 : m_stages.back().frameCnt;
+		os << std::fixed << std::setprecision(2) << "pipeline: " << frameSize << " frames, " << m_runTime << "s, "
+			<< (m_runTime > 0. ? frameSize / m_runTime : 0.) << " fps" << std::endl;
+		for (int stageIdx = 0; stageIdx < m_stages.size(); stageIdx++) {
+			const Stage& stage = m_stages[stageIdx];
+			os << "  " << std::left << std::setw(12) << stage.name << std::right << stage.frameCnt << " frames, "
+				<< (stage.busyTime > 0. ? stage.frameCnt / stage.busyTime : 0.) << " fps busy, "
+				<< (m_runTime > 0. ? 100. * stage.busyTime / m_runTime : 0.) << "% busy";
+			if (stageIdx < m_queues.size())
+				os << ", queue " << m_queues[stageIdx]->GetMeanSize() << "/" << m_queues[stageIdx]->GetCapacity();
+			os << std::endl;
+		}
+		os.unsetf(std::ios::floatfield);
+	}
+
+private:
+	struct Stage
+	{
+		std::string name;
+		std::function<bool(Frame&)> func;
+		int frameCnt = 0;
+		double busyTime = 0.;
+	};
+
+	int m_queueCapacity;
+	double m_runTime = 0.;
+	std::vector<Stage> m_stages;
+	std::vector<std::unique_ptr<BoundedQueue<Frame>>> m_queues;
+	std::mutex m_poolMutex;
+	std::vector<Frame> m_pool;					// frames done by the last stage, waiting for the source
+
+	void RunStage(const int& stageIdx)
+	{
+		Stage& stage = m_stages[stageIdx];
+		BoundedQueue<Frame>* input = stageIdx > 0 ? m_queues[stageIdx - 1].get() : nullptr;
+		BoundedQueue<Frame>* output = stageIdx < m_queues.size() ? m_queues[stageIdx].get() : nullptr;
+		Frame frame;
+		while (true) {
+			if (input != nullptr && !input->Pop(frame))
+				break;
+			if (input == nullptr) {
+				std::unique_lock<std::mutex> locker(m_poolMutex);
+				if (!m_pool.empty()) {
+					frame = std::move(m_pool.back());
+					m_pool.pop_back();
+				}
+			}
+
+			const auto start = std::chrono::steady_clock::now();
+			const bool valid = stage.func(frame);
+			stage.busyTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			if (!valid)
+				break;
+			stage.frameCnt++;
+			if (output != nullptr)
+				output->Push(std::move(frame));
+			else {
+				std::unique_lock<std::mutex> locker(m_poolMutex);
+				m_pool.emplace_back(std::move(frame));
+			}
+		}
+		if (output != nullptr)
+			output->Close();
+	}
+};
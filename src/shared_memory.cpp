@@ -0,0 +1,140 @@
+#include <cstdint>
+#include "shared_memory.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+#ifdef _WIN32
+bool SharedMemory::Create(const std::string& name, const size_t& size)
+{
+	Close();
+	m_name = "Local\\" + name;
+	m_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+		DWORD(uint64_t(size) >> 32), DWORD(size & 0xffffffff), m_name.c_str());
+	if (m_mapping == NULL) {
+		m_mapping = nullptr;
+		return false;
+	}
+	// an existing mapping of the name belongs to another process
+	if (GetLastError() == ERROR_ALREADY_EXISTS) {
+		Close();
+		return false;
+	}
+
+	m_data = static_cast<char*>(MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size));
+	if (m_data == nullptr) {
+		Close();
+		return false;
+	}
+	m_size = size;
+	m_owner = true;
+	return true;
+}
+
+
+bool SharedMemory::Open(const std::string& name)
+{
+	Close();
+	m_name = "Local\\" + name;
+	m_mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, m_name.c_str());
+	if (m_mapping == NULL) {
+		m_mapping = nullptr;
+		return false;
+	}
+
+	m_data = static_cast<char*>(MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+	MEMORY_BASIC_INFORMATION info;
+	if (m_data == nullptr || VirtualQuery(m_data, &info, sizeof(info)) == 0) {
+		Close();
+		return false;
+	}
+	m_size = info.RegionSize;
+	return true;
+}
+
+
+void SharedMemory::Close()
+{
+	if (m_data != nullptr)
+		UnmapViewOfFile(m_data);
+	if (m_mapping != nullptr)
+		CloseHandle(m_mapping);
+	m_data = nullptr;
+	m_mapping = nullptr;
+	m_size = 0;
+	m_owner = false;
+}
+
+#else
+bool SharedMemory::Create(const std::string& name, const size_t& size)
+{
+	Close();
+	m_name = "/" + name;
+	// an existing segment of the name may be in use by another process, it is never taken over. one left by a
+	// crashed creator has to be removed by hand
+	m_fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (m_fd < 0)
+		return false;
+	m_owner = true;
+
+	if (ftruncate(m_fd, off_t(size)) != 0) {
+		Close();
+		return false;
+	}
+	void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+	if (data == MAP_FAILED) {
+		Close();
+		return false;
+	}
+	m_data = static_cast<char*>(data);
+	m_size = size;
+	return true;
+}
+
+
+bool SharedMemory::Open(const std::string& name)
+{
+	Close();
+	m_name = "/" + name;
+	m_fd = shm_open(m_name.c_str(), O_RDWR, 0600);
+	if (m_fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(m_fd, &st) != 0 || st.st_size == 0) {
+		Close();
+		return false;
+	}
+	void* data = mmap(nullptr, size_t(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+	if (data == MAP_FAILED) {
+		Close();
+		return false;
+	}
+	m_data = static_cast<char*>(data);
+	m_size = size_t(st.st_size);
+	return true;
+}
+
+
+void SharedMemory::Close()
+{
+	if (m_data != nullptr)
+		munmap(m_data, m_size);
+	if (m_fd >= 0)
+		close(m_fd);
+	if (m_owner)
+		shm_unlink(m_name.c_str());
+	m_data = nullptr;
+	m_fd = -1;
+	m_size = 0;
+	m_owner = false;
+}
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+
+// named read-write memory shared between processes, the creator removes the name when it closes. creating a name
+// that exists fails
+class SharedMemory
+{
+public:
+	SharedMemory() {}
+	~SharedMemory() { Close(); }
+	SharedMemory(const SharedMemory&) = delete;
+	SharedMemory& operator=(const SharedMemory&) = delete;
+
+	bool Create(const std::string& name, const size_t& size);
+	bool Open(const std::string& name);
+	void Close();
+	bool IsOpen() const { return m_data != nullptr; }
+	char* GetData() const { return m_data; }
+	size_t GetSize() const { return m_size; }
+
+private:
+	char* m_data = nullptr;
+	size_t m_size = 0;
+	bool m_owner = false;
+	std::string m_name;
+#ifdef _WIN32
+	void* m_mapping = nullptr;
+#else
+	int m_fd = -1;
+#endif
+};
@@ -2,35 +2,76 @@
 #include <fstream>
 #include <Eigen/Eigen>
 #include <filesystem>
+#include <cstring>
 #include "skel_driver.h"
 #include "math_util.h"
+#include "text_parser.h"
 
 
 std::vector<std::map<int, Eigen::Matrix4Xf>> ParseSkels(const std::string& filename)
 {
-	std::ifstream fs(filename);
-	if (!fs.is_open()) {
-		std::cerr << "file not exist: " << filename << std::endl;
+	std::vector<std::map<int, Eigen::Matrix4Xf>> skels;
+	if (!ParseSkels(filename, skels))
 		std::abort();
+	return skels;
+}
+
+
+bool ParseSkels(const std::string& filename, std::vector<std::map<int, Eigen::Matrix4Xf>>& skels)
+{
+	if (IsSkelFile(filename)) {
+		SkelFile file;
+		if (!file.Open(filename))
+			return false;
+		skels.resize(file.GetFrameSize());
+		for (int frameIdx = 0; frameIdx < file.GetFrameSize(); frameIdx++)
+			skels[frameIdx] = file.GetSkels(frameIdx);
+		return true;
 	}
 
-	int jointSize, frameSize, personSize, identity;
-	fs >> jointSize >> frameSize;
+	const MappedFile file(filename);
+	if (!file.IsOpen()) {
+		std::cerr << "file not exist: " << filename << std::endl;
+		return false;
+	}
 
-	std::vector<std::map<int, Eigen::Matrix4Xf>> skels(frameSize);
+	// locate frames by skipping tokens, then convert frames in parallel. a truncated file fails the scan, before any
+	// frame is converted from a position the scan never reached
+	TextParser parser(file.GetData(), file.GetData() + file.GetSize());
+	const int jointSize = parser.Parse<int>();
+	const int frameSize = parser.Parse<int>();
+	bool fail = parser.Fail() || jointSize < 0 || frameSize < 0;
+	std::vector<const char*> frameBegins(fail ? 0 : frameSize);
+	for (int frameIdx = 0; frameIdx < frameBegins.size() && !fail; frameIdx++) {
+		frameBegins[frameIdx] = parser.GetPos();
+		const int personSize = parser.Parse<int>();
+		parser.Skip(std::max(personSize, 0) * (1 + 4 * jointSize));
+		fail = parser.Fail() || personSize < 0;
+	}
+	if (fail) {
+		std::cerr << "invalid skel file: " << filename << std::endl;
+		return false;
+	}
+
+	skels.assign(frameSize, std::map<int, Eigen::Matrix4Xf>());
+#pragma omp parallel for reduction(||:fail)
 	for (int frameIdx = 0; frameIdx < frameSize; frameIdx++) {
-		fs >> personSize;
+		TextParser frameParser(frameBegins[frameIdx], file.GetData() + file.GetSize());
+		const int personSize = frameParser.Parse<int>();
 		for (int pIdx = 0; pIdx < personSize; pIdx++) {
-			fs >> identity;
-			Eigen::Matrix4Xf skel(4, jointSize);
-			for (int i = 0; i < 4; i++)
-				for (int jIdx = 0; jIdx < jointSize; jIdx++)
-					fs >> skel(i, jIdx);
-			skels[frameIdx].insert(std::make_pair(identity, skel));
+			const int identity = frameParser.Parse<int>();
+			Eigen::Matrix<float, 4, -1, Eigen::RowMajor> skel(4, jointSize);
+			frameParser.Parse(skel.data(), int(skel.size()));
+			skels[frameIdx].insert(std::make_pair(identity, Eigen::Matrix4Xf(skel)));
 		}
+		fail = fail || frameParser.Fail();
 	}
-	fs.close();
-	return skels;
+
+	if (fail) {
+		std::cerr << "invalid skel file: " << filename << std::endl;
+		return false;
+	}
+	return true;
 }
 
 
@@ -57,6 +98,200 @@ void SerializeSkels(const std::vector<std::map<int, Eigen::Matrix4Xf>>& skels, c
 }
 
 
+bool IsSkelFile(const std::string& filename)
+{
+	std::ifstream fs(filename, std::ios::binary);
+	char magic[4] = { 0 };
+	fs.read(magic, sizeof(magic));
+	return fs.good() && std::memcmp(magic, "4DSK", sizeof(magic)) == 0;
+}
+
+
+SkelFileWriter::SkelFileWriter(const std::string& filename, const int& jointSize)
+{
+	m_jointSize = jointSize;
+	m_fs.open(filename, std::ios::binary | std::ios::trunc);
+	if (!m_fs.is_open()) {
+		std::cerr << "can not open file: " << filename << std::endl;
+		std::abort();
+	}
+
+	SkelFileHeader header;
+	std::memcpy(header.magic, "4DSK", sizeof(header.magic));
+	header.version = SKEL_FILE_VERSION;
+	header.jointSize = m_jointSize;
+	header.reserved = 0;
+	m_fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	m_fs.flush();
+	m_pos = sizeof(header);
+}
+
+
+void SkelFileWriter::Write(const std::map<int, Eigen::Matrix4Xf>& skels)
+{
+	assert(m_fs.is_open());
+	const size_t personBytes = sizeof(int32_t) + 4 * m_jointSize * sizeof(float);
+	m_buffer.resize(sizeof(int32_t) + skels.size() * personBytes);
+
+	char* ptr = m_buffer.data();
+	const int32_t personSize = int32_t(skels.size());
+	std::memcpy(ptr, &personSize, sizeof(personSize));
+	ptr += sizeof(personSize);
+	for (const auto& skel : skels) {
+		assert(skel.second.cols() == m_jointSize);
+		const int32_t identity = skel.first;
+		std::memcpy(ptr, &identity, sizeof(identity));
+		std::memcpy(ptr + sizeof(identity), skel.second.data(), skel.second.size() * sizeof(float));
+		ptr += personBytes;
+	}
+
+	m_fs.write(m_buffer.data(), m_buffer.size());
+	m_fs.flush();
+	m_offsets.emplace_back(m_pos);
+	m_pos += m_buffer.size();
+}
+
+
+void SkelFileWriter::Close()
+{
+	if (!m_fs.is_open())
+		return;
+
+	SkelFileTrailer trailer;
+	trailer.indexOffset = m_pos;
+	trailer.frameSize = int64_t(m_offsets.size());
+	std::memcpy(trailer.magic, "4DSI", sizeof(trailer.magic));
+	trailer.version = SKEL_FILE_VERSION;
+	m_fs.write(reinterpret_cast<const char*>(m_offsets.data()), m_offsets.size() * sizeof(uint64_t));
+	m_fs.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+	m_fs.close();
+}
+
+
+SkelFile::SkelFile(const std::string& filename)
+{
+	if (!Open(filename))
+		std::abort();
+}
+
+
+bool SkelFile::Open(const std::string& filename)
+{
+	m_file.Close();
+	m_offsets.clear();
+	if (!m_file.Open(filename)) {
+		std::cerr << "file not exist: " << filename << std::endl;
+		return false;
+	}
+
+	SkelFileHeader header;
+	if (m_file.GetSize() < sizeof(header)) {
+		std::cerr << "invalid skel file: " << filename << std::endl;
+		return false;
+	}
+	std::memcpy(&header, m_file.GetData(), sizeof(header));
+	if (std::memcmp(header.magic, "4DSK", sizeof(header.magic)) != 0 || header.version != SKEL_FILE_VERSION) {
+		std::cerr << "unsupported skel file: " << filename << std::endl;
+		return false;
+	}
+
+	// every record is sized by the joint size, one of no skeleton type means a corrupted header
+	bool known = false;
+	for (int type = 0; type < SKEL_TYPE_SIZE; type++)
+		known = known || header.jointSize == GetSkelDef(SkelType(type)).jointSize;
+	if (!known) {
+		std::cerr << "invalid skel file, joint size " << header.jointSize << " of no skeleton type: " << filename << std::endl;
+		return false;
+	}
+	m_jointSize = header.jointSize;
+
+	// an intact trailer of invalid offsets still bounds the frames
+	uint64_t frameEnd = m_file.GetSize();
+	if (!ReadIndex(frameEnd)) {
+		Recover(frameEnd);
+		std::cerr << "skel file without a valid index, recovered " << m_offsets.size() << " frames: " << filename << std::endl;
+	}
+	return true;
+}
+
+
+bool SkelFile::ReadIndex(uint64_t& frameEnd)
+{
+	// use the index of a closed file, its frames run back to back from the header to the index
+	SkelFileTrailer trailer;
+	if (m_file.GetSize() < sizeof(SkelFileHeader) + sizeof(trailer))
+		return false;
+	std::memcpy(&trailer, m_file.GetData() + m_file.GetSize() - sizeof(trailer), sizeof(trailer));
+	if (std::memcmp(trailer.magic, "4DSI", sizeof(trailer.magic)) != 0 || trailer.version != SKEL_FILE_VERSION
+		|| trailer.frameSize < 0 || trailer.frameSize > int64_t(m_file.GetSize() / sizeof(uint64_t))
+		|| trailer.indexOffset < sizeof(SkelFileHeader) || trailer.indexOffset > m_file.GetSize()
+		|| trailer.indexOffset + trailer.frameSize * sizeof(uint64_t) + sizeof(trailer) != m_file.GetSize())
+		return false;
+	frameEnd = trailer.indexOffset;
+
+	m_offsets.resize(trailer.frameSize);
+	std::memcpy(m_offsets.data(), m_file.GetData() + trailer.indexOffset, m_offsets.size() * sizeof(uint64_t));
+	// every frame has to end exactly where the next one starts, the last one at the index
+	const size_t personBytes = sizeof(int32_t) + 4 * m_jointSize * sizeof(float);
+	bool valid = m_offsets.empty() ? trailer.indexOffset == sizeof(SkelFileHeader) : m_offsets.front() == sizeof(SkelFileHeader);
+	for (int frameIdx = 0; frameIdx < m_offsets.size() && valid; frameIdx++) {
+		const uint64_t end = frameIdx + 1 < m_offsets.size() ? m_offsets[frameIdx + 1] : trailer.indexOffset;
+		int32_t personSize = -1;
+		if (end <= trailer.indexOffset && m_offsets[frameIdx] + sizeof(int32_t) <= end)
+			std::memcpy(&personSize, m_file.GetData() + m_offsets[frameIdx], sizeof(personSize));
+		valid = personSize >= 0 && m_offsets[frameIdx] + sizeof(int32_t) + uint64_t(personSize) * personBytes == end;
+	}
+	if (!valid)
+		m_offsets.clear();
+	return valid;
+}
+
+
+void SkelFile::Recover(const uint64_t& frameEnd)
+{
+	// the writer did not finish, recover every complete frame. a crash while closing leaves a prefix of the index,
+	// possibly with part of the trailer, after the last frame: the offsets of the frames found so far
+	const size_t personBytes = sizeof(int32_t) + 4 * m_jointSize * sizeof(float);
+	for (uint64_t pos = sizeof(SkelFileHeader); pos + sizeof(int32_t) <= frameEnd; ) {
+		const uint64_t restBytes = frameEnd - pos;
+		const uint64_t indexBytes = m_offsets.size() * sizeof(uint64_t);
+		if (!m_offsets.empty() && restBytes <= indexBytes + sizeof(SkelFileTrailer)
+			&& std::memcmp(m_file.GetData() + pos, m_offsets.data(), std::min(restBytes, indexBytes)) == 0)
+			break;
+
+		int32_t personSize;
+		std::memcpy(&personSize, m_file.GetData() + pos, sizeof(personSize));
+		const uint64_t frameBytes = sizeof(int32_t) + uint64_t(personSize) * personBytes;
+		if (personSize < 0 || pos + frameBytes > frameEnd)
+			break;
+		m_offsets.emplace_back(pos);
+		pos += frameBytes;
+	}
+}
+
+
+std::map<int, Eigen::Matrix4Xf> SkelFile::GetSkels(const int& frameIdx) const
+{
+	assert(frameIdx >= 0 && frameIdx < m_offsets.size());
+	const char* ptr = m_file.GetData() + m_offsets[frameIdx];
+	int32_t personSize;
+	std::memcpy(&personSize, ptr, sizeof(personSize));
+	ptr += sizeof(personSize);
+
+	std::map<int, Eigen::Matrix4Xf> skels;
+	for (int pIdx = 0; pIdx < personSize; pIdx++) {
+		int32_t identity;
+		std::memcpy(&identity, ptr, sizeof(identity));
+		ptr += sizeof(identity);
+		Eigen::Matrix4Xf skel(4, m_jointSize);
+		std::memcpy(skel.data(), ptr, skel.size() * sizeof(float));
+		ptr += skel.size() * sizeof(float);
+		skels.insert(std::make_pair(identity, skel));
+	}
+	return skels;
+}
+
+
 SkelDriver::SkelDriver(const SkelType& _type, const std::string& modelPath)
 {
 	m_type = _type;
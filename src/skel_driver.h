@@ -3,13 +3,83 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <fstream>
+#include <cstdint>
 #include "skel.h"
+#include "mapped_file.h"
 
 
 std::vector<std::map<int, Eigen::Matrix4Xf>> ParseSkels(const std::string& filename);
+bool ParseSkels(const std::string& filename, std::vector<std::map<int, Eigen::Matrix4Xf>>& skels);	// false on a missing or invalid file
 void SerializeSkels(const std::vector<std::map<int, Eigen::Matrix4Xf>>& skels, const std::string& filename);
 
 
+// binary skeleton file, frames are appended and flushed one at a time so a crashed run keeps every finished frame.
+// frame record: int32 person count, then per person an int32 identity and the 4 x jointSize joints (column major).
+// closing the file appends the frame offset index and a trailer, without them the reader rebuilds the index by scanning
+// up to the last complete frame, a partially written index is not taken for frames.
+struct SkelFileHeader
+{
+	char magic[4];
+	uint32_t version;
+	int32_t jointSize;
+	int32_t reserved;
+};
+
+struct SkelFileTrailer
+{
+	uint64_t indexOffset;
+	int64_t frameSize;
+	char magic[4];
+	uint32_t version;
+};
+
+const uint32_t SKEL_FILE_VERSION = 1;
+bool IsSkelFile(const std::string& filename);
+
+
+class SkelFileWriter
+{
+public:
+	SkelFileWriter(const std::string& filename, const int& jointSize);
+	~SkelFileWriter() { Close(); }
+	SkelFileWriter(const SkelFileWriter&) = delete;
+	SkelFileWriter& operator=(const SkelFileWriter&) = delete;
+
+	int GetFrameSize() const { return int(m_offsets.size()); }
+	void Write(const std::map<int, Eigen::Matrix4Xf>& skels);
+	void Close();
+
+private:
+	std::ofstream m_fs;
+	int m_jointSize;
+	uint64_t m_pos;
+	std::vector<uint64_t> m_offsets;
+	std::vector<char> m_buffer;
+};
+
+
+class SkelFile
+{
+public:
+	SkelFile() {}
+	SkelFile(const std::string& filename);
+
+	bool Open(const std::string& filename);	// false on a missing file, or a header of no known skeleton type
+	int GetFrameSize() const { return int(m_offsets.size()); }
+	int GetJointSize() const { return m_jointSize; }
+	std::map<int, Eigen::Matrix4Xf> GetSkels(const int& frameIdx) const;
+
+private:
+	MappedFile m_file;
+	int m_jointSize = 0;
+	std::vector<uint64_t> m_offsets;
+
+	bool ReadIndex(uint64_t& frameEnd);
+	void Recover(const uint64_t& frameEnd);
+};
+
+
 struct SkelParam
 {
 	SkelType type;
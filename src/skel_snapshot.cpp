@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <thread>
+#include "skel_snapshot.h"
+
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "sequence must be lock-free to be shared between processes");
+
+
+namespace
+{
+	char* GetPayload(SkelSnapshotHeader* header)
+	{
+		return reinterpret_cast<char*>(header) + sizeof(SkelSnapshotHeader);
+	}
+}
+
+
+bool SkelSnapshotWriter::Create(const std::string& name, const SkelType& type, const int& capacity)
+{
+	Close();
+	const SkelDef& def = GetSkelDef(type);
+	const int paramSize = int(SkelParam(type).data.size());
+	const size_t bytes = sizeof(SkelSnapshotHeader) + sizeof(SkelSnapshotFrame)
+		+ capacity * (2 * sizeof(int32_t) + (4 * def.jointSize + paramSize) * sizeof(float));
+	if (capacity <= 0 || !m_memory.Create(name, bytes))
+		return false;
+
+	m_header = new (m_memory.GetData()) SkelSnapshotHeader();
+	m_header->version = SKEL_SNAPSHOT_VERSION;
+	m_header->skelType = int32_t(type);
+	m_header->jointSize = def.jointSize;
+	m_header->paramSize = paramSize;
+	m_header->capacity = capacity;
+	m_header->seq.store(0, std::memory_order_relaxed);
+	SkelSnapshotFrame frame = { -1, 0., 0, 0 };
+	std::memcpy(GetPayload(m_header), &frame, sizeof(frame));
+
+	// readers only accept the snapshot once the magic is visible
+	std::atomic_thread_fence(std::memory_order_release);
+	std::memcpy(m_header->magic, "4DSS", sizeof(m_header->magic));
+	return true;
+}
+
+
+void SkelSnapshotWriter::Publish(const SkelUpdater& updater, const int64_t& frameIdx)
+{
+	if (m_header == nullptr)
+		return;
+	assert(updater.GetType() == SkelType(m_header->skelType));
+	const uint64_t seq = m_header->seq.load(std::memory_order_relaxed);
+	m_header->seq.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	char* ptr = GetPayload(m_header) + sizeof(SkelSnapshotFrame);
+	int personSize = 0;
+	for (const auto& skel : updater.GetSkel3d()) {
+		if (personSize == m_header->capacity)
+			break;
+		const SkelParam* param = updater.GetSkelParam(skel.first);
+		const int32_t info[2] = { skel.first, param != nullptr };
+		std::memcpy(ptr, info, sizeof(info));
+		ptr += sizeof(info);
+		std::memcpy(ptr, skel.second.data(), skel.second.size() * sizeof(float));
+		ptr += 4 * m_header->jointSize * sizeof(float);
+		if (param != nullptr)
+			std::memcpy(ptr, param->data.data(), m_header->paramSize * sizeof(float));
+		else
+			std::memset(ptr, 0, m_header->paramSize * sizeof(float));
+		ptr += m_header->paramSize * sizeof(float);
+		personSize++;
+	}
+
+	SkelSnapshotFrame frame;
+	frame.frameIdx = frameIdx;
+	frame.timestamp = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	frame.personSize = personSize;
+	frame.reserved = 0;
+	std::memcpy(GetPayload(m_header), &frame, sizeof(frame));
+	m_header->seq.store(seq + 2, std::memory_order_release);
+}
+
+
+bool SkelSnapshotReader::Open(const std::string& name)
+{
+	Close();
+	if (!m_memory.Open(name) || m_memory.GetSize() < sizeof(SkelSnapshotHeader))
+		return false;
+
+	// the header belongs to another process, its layout has to match the skeleton type it claims and is kept here,
+	// so a writer changing it later can not move the reads out of the mapping or the params
+	m_header = reinterpret_cast<SkelSnapshotHeader*>(m_memory.GetData());
+	const bool valid = std::memcmp(m_header->magic, "4DSS", sizeof(m_header->magic)) == 0;
+	std::atomic_thread_fence(std::memory_order_acquire);
+	m_type = SkelType(m_header->skelType);
+	m_jointSize = m_header->jointSize;
+	m_paramSize = m_header->paramSize;
+	m_capacity = m_header->capacity;
+	if (!valid || m_header->version != SKEL_SNAPSHOT_VERSION || m_type < 0 || m_type >= SKEL_TYPE_SIZE
+		|| m_jointSize != GetSkelDef(m_type).jointSize || m_paramSize != SkelParam(m_type).data.size() || m_capacity <= 0) {
+		Close();
+		return false;
+	}
+	m_personBytes = 2 * sizeof(int32_t) + (4 * uint64_t(m_jointSize) + m_paramSize) * sizeof(float);
+	if (m_memory.GetSize() < sizeof(SkelSnapshotHeader) + sizeof(SkelSnapshotFrame) + uint64_t(m_capacity) * m_personBytes) {
+		Close();
+		return false;
+	}
+	m_buffer.resize(m_capacity * m_personBytes);
+	m_seq = 0;
+	m_retryCnt = 0;
+	return true;
+}
+
+
+bool SkelSnapshotReader::Read(SkelSnapshot& snapshot)
+{
+	assert(m_header != nullptr);
+	SkelSnapshotFrame frame;
+	while (true) {
+		const uint64_t seq = m_header->seq.load(std::memory_order_acquire);
+		if (seq == m_seq)
+			return false;
+		if (seq & 1) {
+			m_retryCnt++;
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::memcpy(&frame, GetPayload(m_header), sizeof(frame));
+		// a torn frame header is only rejected after the copy, so clamp what it claims
+		frame.personSize = std::clamp(frame.personSize, 0, m_capacity);
+		std::memcpy(m_buffer.data(), GetPayload(m_header) + sizeof(frame), frame.personSize * m_personBytes);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (m_header->seq.load(std::memory_order_relaxed) == seq) {
+			m_seq = seq;
+			break;
+		}
+		m_retryCnt++;
+	}
+
+	snapshot.frameIdx = frame.frameIdx;
+	snapshot.timestamp = frame.timestamp;
+	snapshot.skels.clear();
+	snapshot.params.clear();
+	const char* ptr = m_buffer.data();
+	for (int pIdx = 0; pIdx < frame.personSize; pIdx++) {
+		int32_t info[2];
+		std::memcpy(info, ptr, sizeof(info));
+		ptr += sizeof(info);
+		Eigen::Matrix4Xf& skel = snapshot.skels.insert(std::make_pair(info[0], Eigen::Matrix4Xf(4, m_jointSize))).first->second;
+		std::memcpy(skel.data(), ptr, skel.size() * sizeof(float));
+		ptr += skel.size() * sizeof(float);
+		if (info[1]) {
+			SkelParam& param = snapshot.params.insert(std::make_pair(info[0], SkelParam(m_type))).first->second;
+			std::memcpy(param.data.data(), ptr, m_paramSize * sizeof(float));
+		}
+		ptr += m_paramSize * sizeof(float);
+	}
+	return true;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include "skel_updater.h"
+#include "shared_memory.h"
+
+
+// latest tracking result in shared memory, guarded by a sequence lock: the tracker never waits for readers,
+// readers copy the payload and retry when the sequence was odd (write in progress) or changed meanwhile.
+// payload: SkelSnapshotFrame, then per person an int32 identity, an int32 param flag,
+// the 4 x jointSize joints (column major) and paramSize SkelParam values (zero without a fitted param).
+struct SkelSnapshotHeader
+{
+	char magic[4];
+	uint32_t version;
+	int32_t skelType;
+	int32_t jointSize;
+	int32_t paramSize;
+	int32_t capacity;
+	alignas(64) std::atomic<uint64_t> seq;
+};
+
+
+struct SkelSnapshotFrame
+{
+	int64_t frameIdx;
+	double timestamp;
+	int32_t personSize;
+	int32_t reserved;
+};
+
+const uint32_t SKEL_SNAPSHOT_VERSION = 1;
+
+
+struct SkelSnapshot
+{
+	int64_t frameIdx = -1;
+	double timestamp = 0.;		// steady clock seconds at publishing
+	std::map<int, Eigen::Matrix4Xf> skels;
+	std::map<int, SkelParam> params;
+};
+
+
+class SkelSnapshotWriter
+{
+public:
+	SkelSnapshotWriter() {}
+	~SkelSnapshotWriter() { Close(); }
+	SkelSnapshotWriter(const SkelSnapshotWriter&) = delete;
+	SkelSnapshotWriter& operator=(const SkelSnapshotWriter&) = delete;
+
+	bool Create(const std::string& name, const SkelType& type, const int& capacity = 64);
+	void Close() { m_memory.Close(); m_header = nullptr; }
+	// persons beyond the capacity are left out of the snapshot, does nothing if the memory was not created
+	void Publish(const SkelUpdater& updater, const int64_t& frameIdx);
+
+private:
+	SharedMemory m_memory;
+	SkelSnapshotHeader* m_header = nullptr;
+};
+
+
+class SkelSnapshotReader
+{
+public:
+	SkelSnapshotReader() {}
+	SkelSnapshotReader(const SkelSnapshotReader&) = delete;
+	SkelSnapshotReader& operator=(const SkelSnapshotReader&) = delete;
+
+	bool Open(const std::string& name);
+	void Close() { m_memory.Close(); m_header = nullptr; }
+	SkelType GetType() const { return m_type; }
+	int GetRetryCnt() const { return m_retryCnt; }
+
+	// false if nothing was published since the last successful read
+	bool Read(SkelSnapshot& snapshot);
+
+private:
+	SharedMemory m_memory;
+	SkelSnapshotHeader* m_header = nullptr;
+	SkelType m_type = SKEL_TYPE_NONE;
+	int m_jointSize = 0;
+	int m_paramSize = 0;
+	int m_capacity = 0;
+	size_t m_personBytes = 0;
+	std::vector<char> m_buffer;
+	uint64_t m_seq = 0;
+	int m_retryCnt = 0;
+};
@@ -5,6 +5,62 @@
 #include <opencv2/opencv.hpp>
 
 
+void SkelUpdater::PredictMotion()
+{
+	// an alpha beta filter taking the new joints as they are: the velocity moves by the rate towards the last step
+	// and the squared error by its rate towards the miss of the last prediction
+	const int jointSize = GetSkelDef(m_type).jointSize;
+	for (auto predIter = m_predictedSkels.begin(); predIter != m_predictedSkels.end();) {
+		if (m_skels.find(predIter->first) == m_skels.end()) {
+			m_velocities.erase(predIter->first);
+			m_missErrors.erase(predIter->first);
+			m_missCnts.erase(predIter->first);
+			m_predictionErrors.erase(predIter->first);
+			predIter = m_predictedSkels.erase(predIter);
+		}
+		else
+			predIter++;
+	}
+
+	for (const auto& skel : m_skels) {
+		auto predIter = m_predictedSkels.find(skel.first);
+		if (predIter == m_predictedSkels.end()) {
+			predIter = m_predictedSkels.insert(std::make_pair(skel.first, Eigen::Matrix4Xf::Zero(4, jointSize))).first;
+			m_velocities.insert(std::make_pair(skel.first, Eigen::Matrix3Xf::Zero(3, jointSize)));
+			m_missErrors.insert(std::make_pair(skel.first, Eigen::VectorXf::Constant(jointSize, m_initError)));
+			m_missCnts.insert(std::make_pair(skel.first, Eigen::VectorXi::Zero(jointSize)));
+			m_predictionErrors.insert(std::make_pair(skel.first, Eigen::VectorXf::Constant(jointSize, FLT_MAX)));
+		}
+		Eigen::Matrix4Xf& predicted = predIter->second;
+		Eigen::Matrix3Xf& velocity = m_velocities.find(skel.first)->second;
+		Eigen::VectorXf& missErrors = m_missErrors.find(skel.first)->second;
+		Eigen::VectorXi& missCnts = m_missCnts.find(skel.first)->second;
+		Eigen::VectorXf& errors = m_predictionErrors.find(skel.first)->second;
+		for (int jIdx = 0; jIdx < jointSize; jIdx++) {
+			if (skel.second(3, jIdx) < FLT_EPSILON) {
+				predicted(3, jIdx) = 0.f;
+				continue;
+			}
+
+			const Eigen::Vector3f pos = skel.second.col(jIdx).head(3);
+			if (predicted(3, jIdx) > FLT_EPSILON) {
+				const Eigen::Vector3f miss = pos - predicted.col(jIdx).head<3>();
+				velocity.col(jIdx) += m_velocityRate * miss;
+				missErrors[jIdx] = std::sqrt((1.f - m_errorRate) * missErrors[jIdx] * missErrors[jIdx] + m_errorRate * miss.squaredNorm());
+				missCnts[jIdx]++;
+			}
+			else {
+				velocity.col(jIdx).setZero();
+				missErrors[jIdx] = m_initError;
+				missCnts[jIdx] = 0;
+			}
+			errors[jIdx] = missCnts[jIdx] >= m_minErrorCnt ? missErrors[jIdx] : FLT_MAX;
+			predicted.col(jIdx) << pos + velocity.col(jIdx), skel.second(3, jIdx);
+		}
+	}
+}
+
+
 Eigen::Matrix4Xf SkelTriangulateUpdater::TriangulatePerson(const Eigen::Matrix3Xf& skel2d, const Eigen::Matrix3Xf& projs)
 {
 	const SkelDef& def = GetSkelDef(m_type);
@@ -47,6 +103,7 @@ void SkelTriangulateUpdater::Update(const std::map<int, Eigen::Matrix3Xf>& skels
 		else if (active)
 			m_skels.insert(std::make_pair(corrIter->first, skel));
 	}
+	PredictMotion();
 }
 
 
@@ -64,6 +121,13 @@ void SkelFittingUpdater::SkelInfo::PushPrevBones(const Eigen::Matrix4Xf& skel)
 }
 
 
+const SkelParam* SkelFittingUpdater::GetSkelParam(const int& identity) const
+{
+	const auto iter = m_skelInfos.find(identity);
+	return iter != m_skelInfos.end() && iter->second.shapeFixed ? &iter->second : nullptr;
+}
+
+
 void SkelFittingUpdater::Update(const std::map<int, Eigen::Matrix3Xf>& skels2d, const Eigen::Matrix3Xf& projs)
 {
 	const SkelDef& def = GetSkelDef(m_type);
@@ -154,5 +218,6 @@ void SkelFittingUpdater::Update(const std::map<int, Eigen::Matrix3Xf>& skels2d,
 			}
 		}
 	}}
+	PredictMotion();
 }
 
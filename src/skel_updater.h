@@ -14,10 +14,35 @@ public:
 	SkelUpdater(const SkelType& _type) { m_type = _type; }
 	virtual void Update(const std::map<int, Eigen::Matrix3Xf>& skels2d, const Eigen::Matrix3Xf& projs) = 0;
 	const std::map<int, Eigen::Matrix4Xf>& GetSkel3d() const { return m_skels; }
+	const SkelType& GetType() const { return m_type; }
+	// fitted pose and shape of a tracked identity, nullptr while it is not fitted
+	virtual const SkelParam* GetSkelParam(const int& identity) const { return nullptr; }
+
+	// constant velocity prediction of the tracked skeletons in the next frame, and per joint the root mean square
+	// distance of the past predictions to the joint in metres. a joint seen anew starts still, at the init error. until
+	// a joint was predicted the min error count of times its error is FLT_MAX, so Associater gates it at the max temp
+	// dist as without prediction
+	const std::map<int, Eigen::Matrix4Xf>& GetPredictedSkel3d() const { return m_predictedSkels; }
+	const std::map<int, Eigen::VectorXf>& GetPredictionErrors() const { return m_predictionErrors; }
+	void SetVelocityRate(const float& rate) { m_velocityRate = rate; }
+	void SetErrorRate(const float& rate) { m_errorRate = rate; }
+	void SetInitError(const float& error) { m_initError = error; }
+	void SetMinErrorCnt(const int& cnt) { m_minErrorCnt = cnt; }
 
 protected:
 	SkelType m_type;
 	std::map<int, Eigen::Matrix4Xf> m_skels;
+
+	float m_velocityRate = 0.5f;
+	float m_errorRate = 0.2f;
+	float m_initError = 0.1f;
+	int m_minErrorCnt = 3;
+	std::map<int, Eigen::Matrix3Xf> m_velocities;
+	std::map<int, Eigen::Matrix4Xf> m_predictedSkels;
+	std::map<int, Eigen::VectorXf> m_missErrors;			// m_missErrors[identity](jIdx), running error of the predictions
+	std::map<int, Eigen::VectorXi> m_missCnts;				// m_missCnts[identity](jIdx), predictions the error is taken over
+	std::map<int, Eigen::VectorXf> m_predictionErrors;
+	void PredictMotion();
 };
 
 
@@ -53,6 +78,7 @@ public:
 	void SetMinTriangulateJCnt(const int& jcnt) { m_minTriangulateJCnt = jcnt; }
 	void SetInitActive(const float& active) { m_initActive = active; }
 	void SetActiveRate(const float& rate) { m_activeRate = rate; }
+	virtual const SkelParam* GetSkelParam(const int& identity) const override;
 
 private:
 	struct SkelInfo : public SkelParam
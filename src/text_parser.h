@@ -0,0 +1,74 @@
+#pragma once
+#include <charconv>
+#include <cstddef>
+#include <type_traits>
+
+
+// whitespace separated token reader over an in-memory buffer (typically a MappedFile).
+// Skip() only walks over characters, so a first sequential pass can cheaply locate record boundaries
+// and the records can then be converted in parallel by independent parsers.
+class TextParser
+{
+public:
+	TextParser(const char* begin, const char* end) { m_pos = begin; m_end = end; }
+	const char* GetPos() const { return m_pos; }
+	size_t GetRestSize() const { return size_t(m_end - m_pos); }		// an upper bound of the tokens left
+	bool Fail() const { return m_fail; }
+
+	bool Eof()
+	{
+		SkipSpace();
+		return m_pos == m_end;
+	}
+
+	void Skip(const int& cnt = 1)
+	{
+		for (int i = 0; i < cnt; i++) {
+			SkipSpace();
+			if (m_pos == m_end) {
+				m_fail = true;
+				return;
+			}
+			while (m_pos != m_end && !IsSpace(*m_pos))
+				m_pos++;
+		}
+	}
+
+	template<typename T>
+	T Parse()
+	{
+		SkipSpace();
+		T value = T(0);
+		std::from_chars_result result;
+		if constexpr (std::is_floating_point<T>::value)
+			result = std::from_chars(m_pos, m_end, value, std::chars_format::general);
+		else
+			result = std::from_chars(m_pos, m_end, value);
+		if (result.ec != std::errc() || (result.ptr != m_end && !IsSpace(*result.ptr))) {
+			m_fail = true;
+			Skip();
+			return T(0);
+		}
+		m_pos = result.ptr;
+		return value;
+	}
+
+	template<typename T>
+	void Parse(T* dst, const int& cnt)
+	{
+		for (int i = 0; i < cnt; i++)
+			dst[i] = Parse<T>();
+	}
+
+private:
+	const char* m_pos;
+	const char* m_end;
+	bool m_fail = false;
+
+	static bool IsSpace(const char& c) { return c == ' ' || c == '\n' || c == '\t' || c == '\r'; }
+	void SkipSpace()
+	{
+		while (m_pos != m_end && IsSpace(*m_pos))
+			m_pos++;
+	}
+};
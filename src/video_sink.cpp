@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <iostream>
+#include "video_sink.h"
+
+
+VideoSink::VideoSink(const std::vector<std::string>& filenames, const double& fps, const int& poolSize, const bool& dropFrames)
+{
+	m_filenames = filenames;
+	m_fps = fps;
+	m_dropFrames = dropFrames;
+	m_buffers.resize(std::max(poolSize, 1));
+	for (int bufferIdx = 0; bufferIdx < m_buffers.size(); bufferIdx++) {
+		m_buffers[bufferIdx].mosaics.resize(m_filenames.size());
+		m_free.emplace_back(bufferIdx);
+	}
+
+	m_queues.resize(m_filenames.size());
+	m_writers.resize(m_filenames.size());
+	m_encodeCnts.resize(m_filenames.size(), 0);
+	for (int videoIdx = 0; videoIdx < m_filenames.size(); videoIdx++)
+		m_workers.emplace_back(&VideoSink::Encode, this, videoIdx);
+}
+
+
+int VideoSink::Acquire()
+{
+	std::unique_lock<std::mutex> locker(m_mutex);
+	if (m_free.empty() && m_dropFrames) {
+		m_dropCnt++;
+		return -1;
+	}
+	m_freeCond.wait(locker, [&] { return !m_free.empty(); });
+	const int bufferIdx = m_free.back();
+	m_free.pop_back();
+	return bufferIdx;
+}
+
+
+void VideoSink::Submit(const int& bufferIdx)
+{
+	std::unique_lock<std::mutex> locker(m_mutex);
+	m_buffers[bufferIdx].pending = int(m_filenames.size());
+	for (auto&& queue : m_queues)
+		queue.emplace_back(bufferIdx);
+	m_submitCnt++;
+	m_queueCond.notify_all();
+}
+
+
+void VideoSink::Close()
+{
+	{
+		std::unique_lock<std::mutex> locker(m_mutex);
+		m_closed = true;
+		m_queueCond.notify_all();
+	}
+	for (auto&& worker : m_workers)
+		if (worker.joinable())
+			worker.join();
+	for (auto&& writer : m_writers)
+		writer.release();
+}
+
+
+void VideoSink::Encode(const int& videoIdx)
+{
+	std::deque<int>& queue = m_queues[videoIdx];
+	cv::VideoWriter& writer = m_writers[videoIdx];
+	bool failed = false;
+	while (true) {
+		int bufferIdx;
+		{
+			std::unique_lock<std::mutex> locker(m_mutex);
+			m_queueCond.wait(locker, [&] { return !queue.empty() || m_closed; });
+			if (queue.empty())
+				break;
+			bufferIdx = queue.front();
+			queue.pop_front();
+		}
+
+		// the first mosaic fixes the video size
+		const cv::Mat& mosaic = m_buffers[bufferIdx].mosaics[videoIdx];
+		if (!writer.isOpened() && !failed && !writer.open(m_filenames[videoIdx],
+			cv::VideoWriter::fourcc('m', 'p', '4', 'v'), m_fps, cv::Size(mosaic.cols, mosaic.rows))) {
+			std::cerr << "can not open video: " << m_filenames[videoIdx] << std::endl;
+			failed = true;
+		}
+		if (!failed) {
+			writer.write(mosaic);
+			m_encodeCnts[videoIdx]++;
+		}
+
+		std::unique_lock<std::mutex> locker(m_mutex);
+		if (--m_buffers[bufferIdx].pending == 0) {
+			m_free.emplace_back(bufferIdx);
+			m_freeCond.notify_one();
+		}
+	}
+}
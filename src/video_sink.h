@@ -0,0 +1,58 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+
+// encodes sets of mosaics into video files on background workers, one worker per file so each video keeps the frame order.
+// mosaics are painted into a fixed pool of reused buffers: once every buffer is queued for encoding, Acquire either
+// waits for a worker to finish one (back-pressure) or, with dropFrames, returns -1 so the caller skips the frame.
+class VideoSink
+{
+public:
+	VideoSink(const std::vector<std::string>& filenames, const double& fps, const int& poolSize = 4, const bool& dropFrames = false);
+	~VideoSink() { Close(); }
+	VideoSink(const VideoSink&) = delete;
+	VideoSink& operator=(const VideoSink&) = delete;
+
+	int Acquire();
+	std::vector<cv::Mat>& GetMosaics(const int& bufferIdx) { return m_buffers[bufferIdx].mosaics; }
+	void Submit(const int& bufferIdx);
+	void Close();
+
+	// read after Close. frames written to every video, a video that failed to open writes none
+	int GetEncodeCnt() const { return m_encodeCnts.empty() ? 0 : *std::min_element(m_encodeCnts.begin(), m_encodeCnts.end()); }
+	int GetSubmitCnt() const { return m_submitCnt; }
+	int GetDropCnt() const { return m_dropCnt; }
+
+private:
+	struct Buffer
+	{
+		std::vector<cv::Mat> mosaics;	// one per video
+		int pending = 0;				// workers that still have to encode it
+	};
+
+	std::vector<std::string> m_filenames;
+	double m_fps;
+	bool m_dropFrames;
+	bool m_closed = false;
+	int m_submitCnt = 0;
+	std::vector<int> m_encodeCnts;		// m_encodeCnts[videoIdx], frames passed to its open writer
+	int m_dropCnt = 0;
+
+	std::vector<Buffer> m_buffers;
+	std::vector<int> m_free;
+	std::vector<std::deque<int>> m_queues;
+	std::vector<cv::VideoWriter> m_writers;
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_freeCond, m_queueCond;
+
+	void Encode(const int& videoIdx);
+};